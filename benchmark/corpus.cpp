@@ -0,0 +1,188 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "corpus.hpp"
+
+#include <fstream>
+#include <random>
+#include <sstream>
+
+using namespace standardese_bench;
+
+namespace
+{
+enum class entity_kind
+{
+    function,
+    class_,
+    enum_,
+    alias,
+};
+
+struct entity
+{
+    entity_kind kind;
+    std::string name;
+    std::string qualified_name;
+    unsigned    overloads;
+    bool        commented;
+};
+
+std::string namespace_name(unsigned file, unsigned level)
+{
+    return "ns" + std::to_string(file) + "_" + std::to_string(level);
+}
+
+std::string scope_of(unsigned file, unsigned depth)
+{
+    std::string result = "bench::";
+    for (auto level = 0u; level != depth; ++level)
+        result += namespace_name(file, level) + "::";
+    return result;
+}
+
+// returns a count with the given average
+unsigned random_count(std::mt19937& rng, double average)
+{
+    if (average <= 0.)
+        return 0u;
+    return std::poisson_distribution<unsigned>(average)(rng);
+}
+
+bool random_bool(std::mt19937& rng, double probability)
+{
+    return std::bernoulli_distribution(probability)(rng);
+}
+
+class corpus_writer
+{
+public:
+    explicit corpus_writer(const corpus_config& config) : config_(config), rng_(config.seed)
+    {
+        // all entities are known up front, so comments can link to any file
+        for (auto file = 0u; file != config_.files; ++file)
+        {
+            files_.emplace_back();
+            auto scope = scope_of(file, config_.depth);
+            for (auto i = 0u; i != config_.entities_per_file; ++i)
+            {
+                auto kind = entity_kind(i % 4u);
+                auto name = std::string(kind == entity_kind::function
+                                            ? "func"
+                                            : kind == entity_kind::class_
+                                                  ? "type"
+                                                  : kind == entity_kind::enum_ ? "kind" : "alias")
+                            + std::to_string(file) + "_" + std::to_string(i);
+                files_.back().push_back({kind, name, scope + name,
+                                         kind == entity_kind::function
+                                             ? random_count(rng_, config_.overload_density)
+                                             : 0u,
+                                         random_bool(rng_, config_.comment_density)});
+                all_.push_back(files_.back().back().qualified_name);
+            }
+        }
+    }
+
+    std::string header(unsigned file)
+    {
+        std::ostringstream out;
+        out << "#ifndef BENCH_FILE" << file << "_HPP\n#define BENCH_FILE" << file << "_HPP\n\n";
+        out << "/// \\file\n/// Synthetic header number " << file << ".\n\n";
+
+        out << "namespace bench\n{\n";
+        for (auto level = 0u; level != config_.depth; ++level)
+            out << "namespace " << namespace_name(file, level) << "\n{\n";
+
+        for (auto& e : files_[file])
+            write_entity(out, e);
+
+        for (auto level = 0u; level != config_.depth; ++level)
+            out << "}\n";
+        out << "}\n\n#endif\n";
+        return out.str();
+    }
+
+private:
+    void write_comment(std::ostream& out, const std::string& indent, const entity& e,
+                       bool parameter)
+    {
+        out << indent << "/// \\brief Brief documentation of `" << e.name << "`.\n";
+        out << indent << "///\n";
+        out << indent << "/// Details of the entity";
+        for (auto links = random_count(rng_, config_.link_density); links != 0u; --links)
+            out << ", see [" << all_[std::uniform_int_distribution<std::size_t>(
+                                         0u, all_.size() - 1u)(rng_)]
+                << "]()";
+        out << ".\n";
+        if (parameter)
+        {
+            out << indent << "/// \\param a The first parameter.\n";
+            out << indent << "/// \\returns The result of the computation.\n";
+        }
+    }
+
+    void write_entity(std::ostream& out, const entity& e)
+    {
+        if (e.commented)
+            write_comment(out, "", e, e.kind == entity_kind::function);
+
+        switch (e.kind)
+        {
+        case entity_kind::function:
+            out << "int " << e.name << "(int a);\n";
+            // the overloads are uncommented, so they are grouped with the first one
+            for (auto i = 0u; i != e.overloads; ++i)
+            {
+                out << "int " << e.name << "(int a";
+                for (auto j = 0u; j <= i; ++j)
+                    out << ", long b" << j;
+                out << ");\n";
+            }
+            break;
+
+        case entity_kind::class_:
+            out << "class " << e.name << "\n{\npublic:\n";
+            for (auto i = 0u; i != 3u; ++i)
+            {
+                auto member = entity{entity_kind::function, "member" + std::to_string(i), "", 0u,
+                                     random_bool(rng_, config_.comment_density)};
+                if (member.commented)
+                    write_comment(out, "    ", member, true);
+                out << "    int " << member.name << "(int a) const;\n";
+            }
+            out << "\nprivate:\n    int value_;\n};\n";
+            break;
+
+        case entity_kind::enum_:
+            out << "enum class " << e.name << "\n{\n    first,\n    second,\n    third,\n};\n";
+            break;
+
+        case entity_kind::alias:
+            out << "using " << e.name << " = const int*;\n";
+            break;
+        }
+        out << '\n';
+    }
+
+    const corpus_config&                   config_;
+    std::mt19937                           rng_;
+    std::vector<std::vector<entity>>       files_;
+    std::vector<std::string>               all_;
+};
+} // namespace
+
+std::vector<std::string> standardese_bench::write_corpus(const corpus_config& config,
+                                                         const std::string&   directory)
+{
+    corpus_writer writer(config);
+
+    std::vector<std::string> result;
+    for (auto file = 0u; file != config.files; ++file)
+    {
+        result.push_back(directory + "/file" + std::to_string(file) + ".hpp");
+        std::ofstream out(result.back());
+        out << writer.header(file);
+    }
+    return result;
+}
@@ -0,0 +1,31 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef STANDARDESE_BENCHMARK_CORPUS_HPP_INCLUDED
+#define STANDARDESE_BENCHMARK_CORPUS_HPP_INCLUDED
+
+#include <string>
+#include <vector>
+
+namespace standardese_bench
+{
+// the shape of a synthetic header tree
+struct corpus_config
+{
+    unsigned files             = 16u;
+    unsigned entities_per_file = 64u;
+    unsigned depth             = 2u;    // namespaces around the entities of a file
+    double   overload_density  = 0.5;   // average number of extra overloads of a function
+    double   comment_density   = 0.8;   // fraction of entities with a comment
+    double   link_density      = 1.0;   // average number of links in a comment
+    unsigned seed              = 42u;
+};
+
+// writes the headers of the corpus into `directory`, which must exist,
+// the same configuration always produces the same corpus
+// returns the paths of the headers
+std::vector<std::string> write_corpus(const corpus_config& config, const std::string& directory);
+} // namespace standardese_bench
+
+#endif // STANDARDESE_BENCHMARK_CORPUS_HPP_INCLUDED
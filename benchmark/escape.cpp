@@ -0,0 +1,114 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "escape.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+#include "../src/markup/escape.hpp"
+
+using namespace standardese_bench;
+
+namespace
+{
+// random characters from `alphabet`,
+// with the given fraction replaced by characters from `special`
+std::string generate_input(std::size_t bytes, unsigned seed, const char* alphabet,
+                           const char* special, double density)
+{
+    std::mt19937                           engine(seed);
+    std::uniform_real_distribution<double> is_special(0.0, 1.0);
+
+    auto alphabet_size = std::char_traits<char>::length(alphabet);
+    auto special_size  = std::char_traits<char>::length(special);
+
+    std::string result(bytes, ' ');
+    for (auto& c : result)
+        if (is_special(engine) < density)
+            c = special[engine() % special_size];
+        else
+            c = alphabet[engine() % alphabet_size];
+    return result;
+}
+
+using escape_function = void (*)(std::string&, const char*, std::size_t);
+
+// the best of a couple of runs
+double measure(escape_function f, const std::string& input)
+{
+    std::string out;
+    out.reserve(input.size() * 6u);
+
+    auto best = std::chrono::duration<double>::max();
+    for (auto run = 0; run != 5; ++run)
+    {
+        out.clear();
+        auto start = std::chrono::steady_clock::now();
+        f(out, input.data(), input.size());
+        auto end = std::chrono::steady_clock::now();
+        best     = std::min(best, std::chrono::duration<double>(end - start));
+    }
+
+    return double(input.size()) / 1e6 / best.count();
+}
+} // namespace
+
+std::vector<escape_result> standardese_bench::benchmark_escaping(std::size_t bytes, unsigned seed)
+{
+    namespace detail = standardese::markup::detail;
+
+    // text as it appears in a synopsis, and URLs as they appear in links
+    const char* text_alphabet = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 "
+                                "_(){}[];:,.*+-=!?";
+    const char* text_special  = "&<>\"'/";
+    const char* url_alphabet  = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789"
+                               "-_./#";
+    const char* url_special   = " &'<>\"[]{}^`|\\";
+
+    struct input
+    {
+        const char* name;
+        bool        url;
+        const char* special;
+        double      density;
+    };
+    const input inputs[] = {
+        {"html_text/none", false, text_special, 0.0},
+        {"html_text/sparse", false, text_special, 0.02},
+        {"html_text/synopsis", false, text_special, 0.1},
+        {"html_text/dense", false, text_special, 0.5},
+        {"html_url/none", true, url_special, 0.0},
+        {"html_url/sparse", true, url_special, 0.02},
+        {"html_url/dense", true, url_special, 0.5},
+    };
+
+    std::vector<escape_result> result;
+    for (auto& in : inputs)
+    {
+        auto str = generate_input(bytes, seed, in.url ? url_alphabet : text_alphabet, in.special,
+                                  in.density);
+        if (in.url)
+        {
+            result.push_back(
+                {std::string(in.name) + "/simd", measure(detail::write_html_url, str)});
+            result.push_back(
+                {std::string(in.name) + "/scalar", measure(detail::write_html_url_scalar, str)});
+        }
+        else
+        {
+            result.push_back(
+                {std::string(in.name) + "/simd", measure(detail::write_html_text, str)});
+            result.push_back(
+                {std::string(in.name) + "/scalar", measure(detail::write_html_text_scalar, str)});
+        }
+    }
+    return result;
+}
+
+const char* standardese_bench::escape_instruction_set() noexcept
+{
+    return standardese::markup::detail::escape_instruction_set();
+}
@@ -0,0 +1,30 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef STANDARDESE_BENCHMARK_ESCAPE_HPP_INCLUDED
+#define STANDARDESE_BENCHMARK_ESCAPE_HPP_INCLUDED
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace standardese_bench
+{
+// the throughput of one escaping function on one kind of input
+struct escape_result
+{
+    std::string name;
+    double      mb_per_s;
+};
+
+// escapes `bytes` of generated input with the HTML text and URL escaping of the generators,
+// once with the SIMD implementation and once with the scalar one,
+// the inputs range from no special characters to mostly special characters
+std::vector<escape_result> benchmark_escaping(std::size_t bytes, unsigned seed);
+
+// the instruction set used by the SIMD implementation
+const char* escape_instruction_set() noexcept;
+} // namespace standardese_bench
+
+#endif // STANDARDESE_BENCHMARK_ESCAPE_HPP_INCLUDED
@@ -0,0 +1,264 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include <cppast/libclang_parser.hpp>
+
+#include <standardese/comment.hpp>
+#include <standardese/doc_entity.hpp>
+#include <standardese/index.hpp>
+#include <standardese/linker.hpp>
+#include <standardese/markup/document.hpp>
+#include <standardese/markup/generator.hpp>
+
+#include "corpus.hpp"
+#include "escape.hpp"
+
+using namespace standardese_bench;
+
+namespace
+{
+// the benchmark is not interested in the diagnostics
+class null_logger : public cppast::diagnostic_logger
+{
+    bool do_log(const char*, const cppast::diagnostic&) const override
+    {
+        return true;
+    }
+};
+
+struct options
+{
+    corpus_config corpus;
+    std::string   directory
+        = (std::filesystem::temp_directory_path() / "standardese_bench").string();
+    std::string   output;
+    std::size_t   escape_bytes = 4u * 1024u * 1024u;
+    bool          escape_only  = false;
+};
+
+void print_usage(const char* exe)
+{
+    std::cerr << "usage: " << exe << " [options]\n\n"
+              << "  --help                   prints this help message and exits\n"
+              << "  --files <n>              number of headers\n"
+              << "  --entities <n>           entities per header\n"
+              << "  --depth <n>              namespaces around the entities\n"
+              << "  --overload-density <x>   average number of extra overloads of a function\n"
+              << "  --comment-density <x>    fraction of entities with a comment\n"
+              << "  --link-density <x>       average number of links in a comment\n"
+              << "  --seed <n>               seed of the corpus\n"
+              << "  --directory <path>       where the corpus is written\n"
+              << "  --output <path>          where the JSON results are written, "
+                 "stdout if not given\n"
+              << "  --escape-bytes <n>       input size of the escaping microbenchmarks, "
+                 "0 to disable them\n"
+              << "  --escape-only            only run the escaping microbenchmarks\n";
+}
+
+options parse_options(int argc, char* argv[])
+{
+    options result;
+    for (auto i = 1; i < argc; ++i)
+    {
+        auto is = [&](const char* name) {
+            return std::strcmp(argv[i], name) == 0 && i + 1 < argc;
+        };
+
+        if (std::strcmp(argv[i], "--help") == 0)
+        {
+            print_usage(argv[0]);
+            std::exit(0);
+        }
+        else if (std::strcmp(argv[i], "--escape-only") == 0)
+            result.escape_only = true;
+        else if (is("--files"))
+            result.corpus.files = unsigned(std::stoul(argv[++i]));
+        else if (is("--entities"))
+            result.corpus.entities_per_file = unsigned(std::stoul(argv[++i]));
+        else if (is("--depth"))
+            result.corpus.depth = unsigned(std::stoul(argv[++i]));
+        else if (is("--overload-density"))
+            result.corpus.overload_density = std::stod(argv[++i]);
+        else if (is("--comment-density"))
+            result.corpus.comment_density = std::stod(argv[++i]);
+        else if (is("--link-density"))
+            result.corpus.link_density = std::stod(argv[++i]);
+        else if (is("--seed"))
+            result.corpus.seed = unsigned(std::stoul(argv[++i]));
+        else if (is("--directory"))
+            result.directory = argv[++i];
+        else if (is("--output"))
+            result.output = argv[++i];
+        else if (is("--escape-bytes"))
+            result.escape_bytes = std::stoul(argv[++i]);
+        else
+            throw std::invalid_argument(std::string("unknown option '") + argv[i] + "'");
+    }
+    return result;
+}
+
+// the time of every stage, in the order they were run
+class timings
+{
+public:
+    template <typename Fnc>
+    void measure(const char* stage, Fnc f)
+    {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        auto end = std::chrono::steady_clock::now();
+        stages_.emplace_back(stage, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+
+    void write_json(std::ostream& out, const options& opts, std::size_t bytes,
+                    const std::vector<escape_result>& escaping) const
+    {
+        auto& c = opts.corpus;
+        out << "{\n  \"corpus\": {\"files\": " << c.files
+            << ", \"entities_per_file\": " << c.entities_per_file << ", \"depth\": " << c.depth
+            << ", \"overload_density\": " << c.overload_density
+            << ", \"comment_density\": " << c.comment_density
+            << ", \"link_density\": " << c.link_density << ", \"seed\": " << c.seed << "},\n";
+        out << "  \"bytes_generated\": " << bytes << ",\n";
+        out << "  \"stages\": [";
+        for (auto i = 0u; i != stages_.size(); ++i)
+            out << (i == 0u ? "\n" : ",\n") << "    {\"name\": \"" << stages_[i].first
+                << "\", \"ms\": " << stages_[i].second << '}';
+        out << "\n  ],\n";
+        out << "  \"escaping\": {\"instruction_set\": \"" << escape_instruction_set()
+            << "\", \"kernels\": [";
+        for (auto i = 0u; i != escaping.size(); ++i)
+            out << (i == 0u ? "\n" : ",\n") << "    {\"name\": \"" << escaping[i].name
+                << "\", \"mb_per_s\": " << escaping[i].mb_per_s << '}';
+        out << "\n  ]}\n}\n";
+    }
+
+private:
+    std::vector<std::pair<const char*, double>> stages_;
+};
+
+// runs standardese on the corpus, returns the number of bytes generated
+std::size_t run_corpus(const options& opts, timings& times)
+{
+    std::filesystem::create_directories(opts.directory);
+    auto paths = write_corpus(opts.corpus, opts.directory);
+
+    null_logger                      null;
+    const cppast::diagnostic_logger& logger = null;
+    cppast::cpp_entity_index         index;
+    cppast::libclang_compile_config  compile_config;
+    compile_config.set_flags(cppast::cpp_standard::cpp_14);
+
+    // libclang is not part of standardese, but it puts the other stages into perspective
+    std::vector<std::unique_ptr<cppast::cpp_file>> files;
+    times.measure("libclang", [&] {
+        cppast::libclang_parser parser(type_safe::ref(logger));
+        for (auto& path : paths)
+        {
+            files.push_back(parser.parse(index, path, compile_config));
+            if (!files.back())
+                throw std::runtime_error("unable to parse '" + path + "'");
+        }
+    });
+
+    standardese::comment_registry comments;
+    times.measure("file_comment_parser", [&] {
+        standardese::file_comment_parser parser(type_safe::ref(logger));
+        for (auto& file : files)
+            parser.parse(type_safe::ref(*file));
+        comments = parser.finish();
+    });
+
+    std::vector<std::unique_ptr<standardese::doc_cpp_file>> doc_files;
+    times.measure("build_doc_entities", [&] {
+        for (auto& file : files)
+            standardese::exclude_entities(comments, index, {}, false, *file);
+        for (auto& file : files)
+        {
+            auto name = file->name();
+            doc_files.push_back(standardese::build_doc_entities(type_safe::ref(comments), index,
+                                                                std::move(file), std::move(name)));
+        }
+    });
+
+    standardese::generation_config gen_config;
+    standardese::synopsis_config   syn_config;
+    std::vector<std::unique_ptr<standardese::markup::document_entity>> docs;
+    times.measure("generate_documentation", [&] {
+        for (auto& file : doc_files)
+        {
+            standardese::markup::subdocument::builder document(file->output_name(),
+                                                               "doc_" + file->link_name());
+            document.add_child(
+                standardese::generate_documentation(gen_config, syn_config, index, *file));
+            docs.push_back(document.finish());
+        }
+    });
+
+    standardese::linker linker;
+    times.measure("linker", [&] {
+        for (auto& doc : docs)
+            standardese::register_documentations(logger, linker, *doc);
+        linker.freeze();
+        for (auto& doc : docs)
+            standardese::resolve_links(logger, linker, *doc);
+    });
+
+    std::size_t bytes         = 0u;
+    auto        run_generator = [&](const char* name, standardese::markup::generator generator) {
+        times.measure(name, [&] {
+            for (auto& doc : docs)
+            {
+                std::ostringstream out;
+                generator(out, *doc);
+                bytes += out.str().size();
+            }
+        });
+    };
+    run_generator("html_generator", standardese::markup::html_generator("", "html"));
+    run_generator("markdown_generator", standardese::markup::markdown_generator(false, "", "md"));
+    run_generator("xml_generator", standardese::markup::xml_generator());
+    run_generator("text_generator", standardese::markup::text_generator());
+
+    return bytes;
+}
+} // namespace
+
+int main(int argc, char* argv[])
+try
+{
+    auto opts = parse_options(argc, argv);
+
+    timings     times;
+    std::size_t bytes = 0u;
+    if (!opts.escape_only)
+        bytes = run_corpus(opts, times);
+
+    std::vector<escape_result> escaping;
+    if (opts.escape_bytes > 0u)
+        escaping = benchmark_escaping(opts.escape_bytes, opts.corpus.seed);
+
+    if (opts.output.empty())
+        times.write_json(std::cout, opts, bytes, escaping);
+    else
+    {
+        std::ofstream out(opts.output);
+        times.write_json(out, opts, bytes, escaping);
+    }
+}
+catch (std::exception& ex)
+{
+    std::cerr << "error: " << ex.what() << "\n\n";
+    print_usage(argv[0]);
+    return 1;
+}
@@ -5,7 +5,9 @@
 #ifndef STANDARDESE_COMMENT_HPP_INCLUDED
 #define STANDARDESE_COMMENT_HPP_INCLUDED
 
+#include <memory>
 #include <mutex>
+#include <thread>
 #include <unordered_map>
 
 #include "index.hpp"
@@ -74,19 +76,62 @@ private:
 /// \returns The unique name of the given entity.
 std::string lookup_unique_name(const comment_registry& registry, const cppast::cpp_entity& e);
 
+/// Computes the unique names of entities and remembers the unique names of their parents.
+///
+/// The unique name of an entity is built from the unique names of all its parents,
+/// so looking them up for many deeply nested entities is costly without a cache.
+class unique_name_cache
+{
+public:
+    /// \effects Creates an empty cache for the comments in `registry`.
+    explicit unique_name_cache(const comment_registry& registry) : registry_(registry) {}
+
+    /// \returns The unique name of the given entity,
+    /// same as [standardese::lookup_unique_name]().
+    /// \requires The comments of the parents of `e` must not change while the cache is used.
+    /// \notes This function is not thread-safe.
+    std::string lookup_unique_name(const cppast::cpp_entity& e);
+
+    /// \returns The unique name of the scope the given entity lives in.
+    /// \requires The comments of the parents of `e` must not change while the cache is used.
+    /// \notes This function is not thread-safe.
+    const std::string& lookup_parent_unique_name(const cppast::cpp_entity& e);
+
+    /// \returns The registry the unique names are computed from.
+    const comment_registry& registry() const noexcept
+    {
+        return *registry_;
+    }
+
+private:
+    type_safe::object_ref<const comment_registry>                   registry_;
+    std::unordered_map<const cppast::cpp_entity*, std::string> scopes_;
+};
+
 /// Parses the comments in several files and connects them in a shared registry.
 class file_comment_parser
 {
 public:
     explicit file_comment_parser(type_safe::object_ref<const cppast::diagnostic_logger> logger,
                                  comment::config config = comment::config())
-    : config_(std::move(config)), logger_(logger)
+    : config_(std::move(config)),
+      parsers_(std::make_shared<comment::parser_pool>(config_)),
+      logger_(logger)
     {}
 
     /// Parse all comments in `file`.
     /// \notes This function is thread-safe.
+    /// \notes The markup of some comments is only parsed once their sections are accessed,
+    /// errors are then logged the same way, so the logger must outlive the comments.
     void parse(type_safe::object_ref<const cppast::cpp_file> file) const;
 
+    /// \returns The cache of parsed comment texts,
+    /// e.g., to query how many comments did not have to be parsed.
+    const comment::parse_cache& parse_cache() const noexcept
+    {
+        return cache_;
+    }
+
     /// Create a registry from this parser.
     /// \returns The registry containing all registered comments.
     /// \requires This function must only be called once,
@@ -94,6 +139,39 @@ public:
     comment_registry finish();
 
 private:
+    using uncommented_map = std::unordered_multimap<std::string, const cppast::cpp_entity*>;
+
+    /// A comment for a module, registered when finishing.
+    struct module_comment
+    {
+        std::string             name;
+        comment::doc_comment    comment;
+        cppast::source_location location;
+    };
+
+    /// Everything a single thread registered while parsing.
+    ///
+    /// The parents of an entity live in the same file as the entity itself,
+    /// so each thread can work on its own registry without any locking.
+    struct thread_state
+    {
+        comment_registry                   registry;
+        unique_name_cache                  unique_names;
+        uncommented_map                    uncommented;
+        std::vector<comment::parse_result> free_comments;
+        std::vector<module_comment>        module_comments;
+
+        thread_state() : unique_names(registry) {}
+    };
+
+    /// \returns The state of the calling thread.
+    /// \notes This function is thread-safe.
+    thread_state& get_thread_state() const;
+
+    /// Merge the states of all threads into a single registry.
+    /// \notes This function is not thread-safe.
+    void merge_thread_states();
+
     /// Connect free comments with an `\entity` command to their respective entities.
     /// \notes This function is not thread-safe.
     void resolve_free_comments();
@@ -102,26 +180,30 @@ private:
     /// \notes This function is not thread-safe.
     void group_uncommented();
 
-    bool register_commented(type_safe::object_ref<const cppast::cpp_entity> entity,
-                            comment::doc_comment comment, bool allow_cmd = true) const;
+    static bool register_commented(comment_registry&                               registry,
+                                   type_safe::object_ref<const cppast::cpp_entity> entity,
+                                   comment::doc_comment                            comment);
 
-    void register_uncommented(type_safe::object_ref<const cppast::cpp_entity> entity) const;
+    /// \effects Registers the comment and if it is a pure "command" comment,
+    /// also remembers the entity as uncommented, so later sections can be attached.
+    static bool register_commented(thread_state&                                   state,
+                                   type_safe::object_ref<const cppast::cpp_entity> entity,
+                                   comment::doc_comment                            comment);
 
-    type_safe::optional_ref<const comment::doc_comment> get_comment(
-        const cppast::cpp_entity& e) const
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        return registry_.get_comment(e);
-    }
+    static void register_uncommented(thread_state&                                   state,
+                                     type_safe::object_ref<const cppast::cpp_entity> entity);
+
+    mutable std::mutex                                                            mutex_;
+    mutable std::unordered_map<std::thread::id, std::unique_ptr<thread_state>> threads_;
 
-    std::string get_parent_unique_name(const cppast::cpp_entity& e) const;
+    mutable comment::parse_cache cache_;
 
-    mutable std::mutex                                                      mutex_;
-    mutable std::unordered_multimap<std::string, const cppast::cpp_entity*> uncommented_;
-    mutable comment_registry                                                registry_;
-    mutable std::vector<comment::parse_result>                              free_comments_;
+    comment_registry                   registry_;
+    uncommented_map                    uncommented_;
+    std::vector<comment::parse_result> free_comments_;
 
     comment::config                                        config_;
+    std::shared_ptr<const comment::parser_pool>            parsers_;
     type_safe::object_ref<const cppast::diagnostic_logger> logger_;
 };
 } // namespace standardese
@@ -7,6 +7,7 @@
 #define STANDARDESE_COMMENT_CONFIG_HPP_INCLUDED
 
 #include <array>
+#include <memory>
 #include <string>
 #include <regex>
 
@@ -15,6 +16,10 @@
 namespace standardese::comment
 {
     /// Configuration of the Comment Parser
+    ///
+    /// The configuration is immutable once it has been created. Copies share
+    /// the same compiled patterns so they are cheap to pass around, e.g., to
+    /// every parser.
     class config
     {
     public:
@@ -48,6 +53,36 @@ namespace standardese::comment
         /// \returns The pattern that introduces a `cmd` inline.
         const std::regex& get_command_pattern(inline_type cmd) const;
 
+        /// \returns Whether `cmd` is only introduced by its default pattern,
+        /// i.e., whether no custom pattern overrides or complements it.
+        /// \group has_default_command_pattern
+        bool has_default_command_pattern(command_type cmd) const;
+
+        /// \group has_default_command_pattern
+        bool has_default_command_pattern(section_type cmd) const;
+
+        /// \group has_default_command_pattern
+        bool has_default_command_pattern(inline_type cmd) const;
+
+        /// \returns A value that identifies this configuration and all its copies.
+        const void* identity() const noexcept {
+            return data_.get();
+        }
+
+        /// \returns The character that forms commands by prefixing it to the command name.
+        char command_character() const {
+            return data_->command_character;
+        }
+
+        /// \returns The default name of this command, i.e., the `name` in `\name`.
+        static const char* command_name(command_type cmd);
+
+        /// \returns The default name of this command, i.e., the `name` in `\name`.
+        static const char* command_name(section_type cmd);
+
+        /// \returns The default name of this command, i.e., the `name` in `\name`.
+        static const char* command_name(inline_type cmd);
+
         /// \returns The name of a [*section_type]() in the resulting documentation.
         const char* inline_section_name(section_type section) const;
 
@@ -56,13 +91,13 @@ namespace standardese::comment
         /// the entire header file even if they do not start with the `\file`
         /// command.
         bool free_file_comments() const {
-            return free_file_comments_;
+            return data_->free_file_comments;
         }
 
         /// \returns Whether uncommented entities should be automatically
         /// grouped with preceding commented entities.
         bool group_uncommented() const {
-            return group_uncommented_;
+            return data_->group_uncommented;
         }
 
     private:
@@ -77,24 +112,26 @@ namespace standardese::comment
         /// \group default_command_pattern
         static std::string default_command_pattern(char command_character, inline_type cmd);
 
-        /// \returns The default name of this command, i.e., the `name` in `\name`.
-        static const char* command_name(command_type cmd);
+        /// \returns The pattern obtained from the command line arguments `options`.
+        static std::regex command_pattern(const std::vector<std::string>& options);
 
-        /// \returns The default name of this command, i.e., the `name` in `\name`.
-        static const char* command_name(section_type cmd);
+        struct data
+        {
+            std::vector<std::regex> special_command_patterns;
+            std::vector<std::regex> section_command_patterns;
+            std::vector<std::regex> inline_command_patterns;
 
-        /// \returns The default name of this command, i.e., the `name` in `\name`.
-        static const char* command_name(inline_type cmd);
+            std::vector<bool> special_command_defaults;
+            std::vector<bool> section_command_defaults;
+            std::vector<bool> inline_command_defaults;
 
-        /// \returns The pattern obtained from the command line arguments `options`.
-        static std::regex command_pattern(const std::vector<std::string>& options);
+            char command_character;
 
-        std::vector<std::regex> special_command_patterns_;
-        std::vector<std::regex> section_command_patterns_;
-        std::vector<std::regex> inline_command_patterns_;
+            bool free_file_comments;
+            bool group_uncommented;
+        };
 
-        bool free_file_comments_;
-        bool group_uncommented_;
+        std::shared_ptr<const data> data_;
     };
 }
 
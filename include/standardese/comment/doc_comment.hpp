@@ -5,6 +5,9 @@
 #ifndef STANDARDESE_COMMENT_DOC_COMMENT_HPP_INCLUDED
 #define STANDARDESE_COMMENT_DOC_COMMENT_HPP_INCLUDED
 
+#include <functional>
+#include <memory>
+
 #include <standardese/comment/metadata.hpp>
 #include <standardese/markup/doc_section.hpp>
 #include <standardese/markup/documentation.hpp>
@@ -58,6 +61,13 @@ namespace comment
         : metadata_(std::move(metadata)), sections_(std::move(sections)), brief_(std::move(brief))
         {}
 
+        /// \effects Creates it giving the metadata and a function that parses the sections.
+        /// The function is called at most once when the sections are first accessed,
+        /// its result provides the sections but not the metadata.
+        /// If it throws, the exception is propagated to the caller and the next access tries again.
+        /// \requires The function must return some sections.
+        doc_comment(comment::metadata metadata, std::function<doc_comment()> parse_sections);
+
         /// \returns The metadata of the comment.
         /// \group metadata
         const comment::metadata& metadata() const noexcept
@@ -72,23 +82,46 @@ namespace comment
         }
 
         /// \returns The non-brief documentation sections.
-        section_range sections() const noexcept
+        /// \notes This function is thread-safe.
+        section_range sections() const
         {
-            return section_range(sections_);
+            return section_range(parsed().sections_);
         }
 
         /// \returns A reference to the brief section, if there is one.
-        type_safe::optional_ref<const markup::brief_section> brief_section() const noexcept
+        /// \notes This function is thread-safe.
+        type_safe::optional_ref<const markup::brief_section> brief_section() const
+        {
+            return type_safe::opt_ref(parsed().brief_.get());
+        }
+
+        /// \returns Whether the comment has a brief section or any other section.
+        /// \notes Unlike checking the sections themselves, this does not parse them.
+        bool has_sections() const noexcept
         {
-            return type_safe::opt_ref(brief_.get());
+            return deferred_ || brief_ || !sections_.empty();
+        }
+
+        /// \returns Whether the sections are only parsed when they are first accessed.
+        bool is_deferred() const noexcept
+        {
+            return deferred_ != nullptr;
         }
 
     private:
+        struct deferred_sections;
+
+        /// \returns The comment that holds the sections, parsing them if necessary.
+        const doc_comment& parsed() const;
+
         comment::metadata                                 metadata_;
         std::vector<std::unique_ptr<markup::doc_section>> sections_;
         std::unique_ptr<markup::brief_section>            brief_;
+        // shared between clones, so the sections are parsed at most once
+        std::shared_ptr<deferred_sections> deferred_;
 
         friend doc_comment merge(comment::metadata data, doc_comment&& other);
+        friend doc_comment clone(const doc_comment& comment);
     };
 
     /// Merges data and a comment.
@@ -97,6 +130,9 @@ namespace comment
     /// `other.metadata()`, which aren't set in `data`.
     doc_comment merge(metadata data, doc_comment&& other);
 
+    /// \returns A deep copy of the comment.
+    doc_comment clone(const doc_comment& comment);
+
     /// \effects Adds a copy of the sections to the documentation builder.
     /// \group set_sections
     void set_sections(markup::entity_documentation::builder& builder, const doc_comment& comment);
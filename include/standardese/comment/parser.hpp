@@ -5,7 +5,14 @@
 #ifndef STANDARDESE_COMMENT_PARSER_HPP_INCLUDED
 #define STANDARDESE_COMMENT_PARSER_HPP_INCLUDED
 
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include <type_safe/optional.hpp>
@@ -28,10 +35,18 @@ namespace standardese
 {
 namespace comment
 {
+    namespace command_extension
+    {
+        class command_extension;
+    } // namespace command_extension
+
     /// The CommonMark parser.
     ///
     /// This is just a RAII wrapper over the `cmark_parser`
     /// and the [standardese::comment::config]().
+    ///
+    /// A parser can be used to parse any number of comments,
+    /// but only one at a time.
     class parser
     {
     public:
@@ -55,9 +70,45 @@ namespace comment
             return config_;
         }
 
+        /// \exclude
+        const command_extension::command_extension& commands() const noexcept
+        {
+            return *commands_;
+        }
+
     private:
-        comment::config config_;
-        cmark_parser*   parser_;
+        comment::config                        config_;
+        cmark_parser*                          parser_;
+        command_extension::command_extension* commands_;
+    };
+
+    /// A set of parsers with the same configuration, one for each thread using it.
+    ///
+    /// Setting up a cmark parser with all our extensions is not free,
+    /// so every thread keeps reusing its own parser.
+    class parser_pool
+    {
+    public:
+        /// \effects Creates an empty pool for parsers using the given configuration.
+        explicit parser_pool(comment::config c = comment::config()) : config_(std::move(c)) {}
+
+        parser_pool(const parser_pool&) = delete;
+        parser_pool& operator=(const parser_pool&) = delete;
+
+        /// \returns The parser of the calling thread, created on first use.
+        /// \notes This function is thread-safe.
+        const parser& get() const;
+
+        /// \returns The config.
+        const comment::config& config() const noexcept
+        {
+            return config_;
+        }
+
+    private:
+        comment::config                                                    config_;
+        mutable std::mutex                                                 mutex_;
+        mutable std::unordered_map<std::thread::id, std::unique_ptr<parser>> parsers_;
     };
 
     /// An unmatched documentation comment.
@@ -113,6 +164,93 @@ namespace comment
     /// \returns The parsed comment.
     /// \throws [standardese::comment::parse_error]() if an error occurred.
     parse_result parse(const parser& p, const std::string& comment, bool has_matching_entity);
+
+    /// Parses the comment with the parser of the calling thread.
+    ///
+    /// The metadata is always parsed right away.
+    /// But if the comment consists of nothing but documentation sections,
+    /// i.e., it has no metadata and no inline entities,
+    /// its markup is only parsed once its sections are accessed,
+    /// with the parser of the thread accessing them.
+    /// \returns The parsed comment.
+    /// \throws [standardese::comment::parse_error]() if an error occurred.
+    /// Errors in markup that is parsed later are thrown by the first access to the sections.
+    parse_result parse(const std::shared_ptr<const parser_pool>& parsers,
+                       const std::string& comment, bool has_matching_entity);
+
+    /// \returns A deep copy of the result.
+    parse_result clone(const parse_result& result);
+
+    /// A cache of parsed comments.
+    ///
+    /// The same comment text is often repeated many times, e.g., `\exclude`,
+    /// so a text that occurs more than once is only parsed twice per configuration
+    /// and later occurrences get a copy of the result.
+    /// Results of texts that have only been seen once are not kept,
+    /// so unique comments do not need twice the memory.
+    class parse_cache
+    {
+    public:
+        parse_cache() = default;
+
+        parse_cache(const parse_cache&) = delete;
+        parse_cache& operator=(const parse_cache&) = delete;
+
+        /// \effects Parses the comment unless the same comment has been parsed
+        /// before with the configuration of `parsers`.
+        /// \returns The parsed comment, same as [standardese::comment::parse]().
+        /// \throws [standardese::comment::parse_error]() if an error occurred.
+        /// \notes This function is thread-safe.
+        parse_result parse(const std::shared_ptr<const parser_pool>& parsers,
+                           const std::string& comment, bool has_matching_entity);
+
+        /// \returns The number of comments that did not have to be parsed.
+        std::size_t hits() const noexcept
+        {
+            return hits_;
+        }
+
+        /// \returns The number of comments that had to be parsed.
+        std::size_t misses() const noexcept
+        {
+            return misses_;
+        }
+
+    private:
+        struct key
+        {
+            std::string     text;
+            comment::config config; // keeps the identity alive
+            bool            has_matching_entity;
+
+            bool operator==(const key& other) const noexcept
+            {
+                return config.identity() == other.config.identity()
+                       && has_matching_entity == other.has_matching_entity && text == other.text;
+            }
+        };
+
+        struct key_hash
+        {
+            std::size_t operator()(const key& k) const noexcept;
+        };
+
+        // the entries are spread over several independently locked maps,
+        // so that threads rarely wait for each other
+        struct shard
+        {
+            std::mutex                                       mutex;
+            std::unordered_map<key, parse_result, key_hash> results;
+            // the hashes of the keys that have been parsed once,
+            // a collision only means that a unique result is kept
+            std::unordered_set<std::size_t> seen;
+        };
+
+        static constexpr std::size_t shard_count = 16;
+
+        std::array<shard, shard_count> shards_;
+        std::atomic<std::size_t>       hits_{0}, misses_{0};
+    };
 } // namespace comment
 } // namespace standardese
 
@@ -7,6 +7,8 @@
 
 #include <memory>
 #include <mutex>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include <type_safe/reference.hpp>
@@ -59,7 +61,11 @@ public:
     };
 
     /// \returns The markup containing the index of all entities registered so far.
+    /// If an entity has been registered multiple times, the first registration is used,
+    /// unless only a later registration of a namespace has documentation.
     /// \requires This function must only be called once.
+    /// It moves the registered entities into the result,
+    /// so a second call would only return the entities registered after the first one.
     /// \notes This function is thread safe.
     std::unique_ptr<markup::entity_index> generate(order o) const;
 
@@ -69,7 +75,8 @@ private:
         std::string name, scope;
         type_safe::variant<std::unique_ptr<markup::entity_index_item>,
                            markup::namespace_documentation::builder>
-            doc;
+                    doc;
+        std::size_t sequence = 0; // the position in the order of registration
 
         entity(std::unique_ptr<markup::entity_index_item> doc, std::string name, std::string scope)
         : name(std::move(name)), scope(std::move(scope)), doc(std::move(doc))
@@ -82,8 +89,11 @@ private:
 
     void insert(entity e) const;
 
-    mutable std::mutex          mutex_;
-    mutable std::vector<entity> entities_; // sorted by scope, then name
+    // the entities are only sorted once they are all registered,
+    // until then each thread appends to its own bucket
+    mutable std::mutex                                                   mutex_;
+    mutable std::unordered_map<std::thread::id, std::vector<entity>> buckets_;
+    mutable std::size_t                                                  next_sequence_ = 0;
 };
 
 /// Registers all entities that needs registration.
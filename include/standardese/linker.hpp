@@ -5,11 +5,17 @@
 #ifndef STANDARDESE_LINKER_HPP_INCLUDED
 #define STANDARDESE_LINKER_HPP_INCLUDED
 
+#include <atomic>
+#include <cstdint>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <stdexcept>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 
+#include <type_safe/optional.hpp>
 #include <type_safe/variant.hpp>
 
 #include <standardese/markup/link.hpp>
@@ -22,6 +28,8 @@ class diagnostic_logger;
 
 namespace standardese
 {
+class doc_entity;
+
 namespace markup
 {
     class document_entity;
@@ -33,25 +41,180 @@ namespace markup
 class linker
 {
 public:
+    /// The scopes in which a relative link name is looked up.
+    ///
+    /// Computing it once per context entity avoids rebuilding the scope names for every link.
+    /// Once the linker is frozen, it also remembers the results of its lookups.
+    class scope_chain
+    {
+    public:
+        /// \effects Creates the chain of scopes of the given context entity and all its parents.
+        /// If there is no context entity, relative links cannot be resolved.
+        explicit scope_chain(type_safe::optional_ref<const cppast::cpp_entity> context);
+
+        scope_chain(scope_chain&&) = default;
+        scope_chain& operator=(scope_chain&&) = default;
+
+        /// \effects Changes the context entity to the given one.
+        /// The remembered results of relative lookups are kept per scope,
+        /// so they are used again once a context with the same scopes comes up.
+        void set_context(type_safe::optional_ref<const cppast::cpp_entity> context);
+
+        /// \returns The number of lookups in this chain that were answered by an earlier lookup
+        /// of the same link name, since the last [standardese::linker::merge_results]().
+        /// \notes Lookups are only remembered once the linker is frozen.
+        std::size_t cache_hits() const noexcept
+        {
+            return cache_hits_;
+        }
+
+        /// \returns The number of lookups in this chain that had to be resolved,
+        /// since the last [standardese::linker::merge_results]().
+        std::size_t cache_misses() const noexcept
+        {
+            return cache_misses_;
+        }
+
+    private:
+        using result_map = std::unordered_map<
+            std::string,
+            type_safe::variant<type_safe::nullvar_t, markup::block_reference, markup::url>>;
+        using scope_key = std::pair<std::string, std::vector<std::size_t>>;
+
+        std::string              scope_;   // the scope of the context, e.g. `ns::type::`
+        std::vector<std::size_t> lengths_; // the length of the scope of each entity in the chain
+
+        // a chain is only used by a single thread, so no locking is needed:
+        // the results of the linker shared by all chains, loaded at the first lookup,
+        // the results of absolute lookups that are not shared yet,
+        // and the results of relative lookups for each scope seen so far
+        mutable std::shared_ptr<const result_map> shared_;
+        mutable result_map                        absolute_;
+        mutable std::map<scope_key, result_map>   relative_;
+        mutable result_map*                       current_ = nullptr; // the ones of the scope_
+        mutable std::size_t                       cache_hits_ = 0, cache_misses_ = 0;
+
+        friend linker;
+    };
+
     void register_external(std::string namespace_name, std::string url);
 
     /// \effects Registers the given documentation under a certain name.
     /// All unresolved links with that name will resolve to the given documentation.
     /// If `force` is `true`, it will replace a previous registered documentation.
     /// \returns `false` if the link name was used twice.
+    /// \throws `std::logic_error` if the linker has been frozen.
     /// \notes This function is thread safe.
     bool register_documentation(std::string link_name, const markup::document_entity& document,
                                 const markup::block_id& documentation, bool force = false) const;
 
-    /// \returns A reference to the documentation for the given linke name, if there is any.
+    /// \effects Remembers the link name of the entity,
+    /// so that links referring to the entity can be resolved without looking up the name.
+    /// \throws `std::logic_error` if the linker has been frozen.
     /// \notes This function is thread safe.
+    void register_entity(const doc_entity& entity) const;
+
+    /// \effects Stops accepting registrations and turns the registered documentations into a
+    /// read-only table, so that later lookups do not need to synchronize anymore.
+    /// \requires No other thread uses the linker during the call.
+    void freeze();
+
+    /// \returns Whether [*freeze]() has been called.
+    bool is_frozen() const noexcept
+    {
+        return frozen_;
+    }
+
+    /// \returns A reference to the documentation for the given linke name, if there is any.
+    /// Relative link names are looked up in the scopes of the context and all of its parents.
+    /// Once the linker is frozen, the scope chain remembers the results of its lookups.
+    /// \notes This function is thread safe, as long as each scope chain is only used by one thread
+    /// and with one linker.
+    /// \group lookup
     type_safe::variant<type_safe::nullvar_t, markup::block_reference, markup::url>
         lookup_documentation(type_safe::optional_ref<const cppast::cpp_entity> context,
                              std::string                                       link_name) const;
 
+    /// \group lookup
+    type_safe::variant<type_safe::nullvar_t, markup::block_reference, markup::url>
+        lookup_documentation(const scope_chain& scopes, std::string link_name) const;
+
+    /// \effects Shares the results of the absolute lookups of the chain with all chains
+    /// created afterwards, and adds its hits and misses to the ones of the linker.
+    /// It is meant to be called once the chain is no longer used, e.g., at the end of a document.
+    /// \notes This function is thread safe, as long as each scope chain is only used by one
+    /// thread.
+    void merge_results(scope_chain& scopes) const;
+
+    /// \returns The number of lookups that were answered by an earlier lookup,
+    /// summed over all merged scope chains.
+    std::size_t cache_hits() const noexcept
+    {
+        return cache_hits_;
+    }
+
+    /// \returns The number of lookups that had to be resolved,
+    /// summed over all merged scope chains.
+    std::size_t cache_misses() const noexcept
+    {
+        return cache_misses_;
+    }
+
+    /// \returns A reference to the documentation of the entity,
+    /// same as looking up its link name without a context.
+    /// \notes This function is thread safe.
+    /// \group lookup
+    type_safe::variant<type_safe::nullvar_t, markup::block_reference, markup::url>
+        lookup_documentation(const doc_entity& entity) const;
+
 private:
+    using lookup_result
+        = type_safe::variant<type_safe::nullvar_t, markup::block_reference, markup::url>;
+
+    // an immutable hash table with open addressing
+    class frozen_map
+    {
+    public:
+        frozen_map() = default;
+
+        explicit frozen_map(std::unordered_map<std::string, markup::block_reference>&& map);
+
+        // returns nullptr if there is no entry
+        const markup::block_reference* lookup(std::string_view name) const noexcept;
+
+    private:
+        struct entry
+        {
+            std::size_t             hash;
+            std::string             name;
+            markup::block_reference reference;
+        };
+
+        std::vector<entry>         entries_;
+        std::vector<std::uint32_t> slots_; // index into entries_ plus one, zero if empty
+    };
+
+    using result_map = scope_chain::result_map;
+
+    lookup_result resolve(const scope_chain& scopes, bool relative, std::string link_name) const;
+
+    type_safe::optional<markup::block_reference> do_lookup(std::string_view link_name) const;
+
     mutable std::mutex                                               mutex_;
     mutable std::unordered_map<std::string, markup::block_reference> map_;
+    frozen_map                                                       frozen_map_;
+    bool                                                             frozen_ = false;
+
+    // the results of the absolute lookups of the merged chains,
+    // a new map replaces it, so that readers only need to load the pointer atomically,
+    // the results that are not worth a copy yet wait in the pending map
+    mutable std::shared_ptr<const result_map> shared_results_;
+    mutable result_map                        pending_results_;
+    mutable std::atomic<std::size_t>          cache_hits_{0}, cache_misses_{0};
+
+    // the link names of the registered entities, resolved once the linker is frozen
+    mutable std::unordered_map<const doc_entity*, std::string> entities_;
+    std::unordered_map<const doc_entity*, lookup_result>       entity_results_;
 
     std::map<std::string, std::string> external_doc_;
 };
@@ -66,8 +229,8 @@ void register_documentations(const cppast::diagnostic_logger& logger, const link
 /// Resolves all unresolved links in a document.
 /// \effects For all [standardese::markup::documentation_link]() entities that are not yet resolved,
 /// uses the linker to resolve them.
-/// \notes This function is *not* thread safe and must be called after the linker is entirely
-/// populated.
+/// \notes This function must be called after the linker is entirely populated.
+/// It is thread safe as long as each document is only resolved by one thread.
 void resolve_links(const cppast::diagnostic_logger& logger, const linker& l,
                    const markup::document_entity& document);
 } // namespace standardese
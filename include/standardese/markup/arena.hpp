@@ -0,0 +1,78 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef STANDARDESE_MARKUP_ARENA_HPP_INCLUDED
+#define STANDARDESE_MARKUP_ARENA_HPP_INCLUDED
+
+#include <cstddef>
+
+namespace standardese
+{
+namespace markup
+{
+    /// \exclude
+    namespace detail
+    {
+        class arena;
+    } // namespace detail
+
+    /// Allocates the markup entities created on the current thread from a single arena.
+    ///
+    /// A document consists of many small entities,
+    /// while the scope is alive, all of them are allocated from one growing buffer,
+    /// without a separate heap allocation for each entity.
+    /// The memory of the arena is released in one step,
+    /// once the scope and every entity allocated in it have been destroyed.
+    /// Entities allocated in the arena can still be destroyed and moved to other threads at any
+    /// time.
+    ///
+    /// Scopes can be nested, the innermost scope is used.
+    class arena_scope
+    {
+    public:
+        /// \effects Creates a new arena and makes it the current one of the calling thread.
+        arena_scope();
+
+        /// \effects Makes the previous arena the current one again,
+        /// and releases the memory if no entity has been allocated in it, or they are all
+        /// destroyed.
+        /// \requires The scope must be destroyed on the thread that created it.
+        ~arena_scope() noexcept;
+
+        arena_scope(const arena_scope&) = delete;
+        arena_scope& operator=(const arena_scope&) = delete;
+
+        /// \returns The number of bytes allocated in the arena so far.
+        std::size_t allocated() const noexcept;
+
+    private:
+        detail::arena* arena_;
+        detail::arena* previous_;
+    };
+
+    /// Allocates the markup entities created on the current thread from the heap,
+    /// even inside an [standardese::markup::arena_scope]().
+    ///
+    /// A single entity that outlives the document would keep the entire arena alive,
+    /// so use it for entities that are kept for later, e.g., parsed comments.
+    class heap_scope
+    {
+    public:
+        /// \effects Makes the heap the allocator of the calling thread.
+        heap_scope() noexcept;
+
+        /// \effects Makes the previous arena the current one again.
+        /// \requires The scope must be destroyed on the thread that created it.
+        ~heap_scope() noexcept;
+
+        heap_scope(const heap_scope&) = delete;
+        heap_scope& operator=(const heap_scope&) = delete;
+
+    private:
+        detail::arena* previous_;
+    };
+} // namespace markup
+} // namespace standardese
+
+#endif // STANDARDESE_MARKUP_ARENA_HPP_INCLUDED
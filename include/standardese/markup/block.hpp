@@ -83,6 +83,10 @@ namespace markup
         /// \returns The escaped string representaton.
         std::string as_output_str() const;
 
+        /// \effects Appends the escaped string representation to `str`,
+        /// without creating a temporary string.
+        void append_output_str(std::string& str) const;
+
     private:
         std::string id_;
     };
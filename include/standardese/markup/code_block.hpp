@@ -5,13 +5,24 @@
 #ifndef STANDARDESE_MARKUP_CODE_BLOCK_HPP_INCLUDED
 #define STANDARDESE_MARKUP_CODE_BLOCK_HPP_INCLUDED
 
+#include <cstdint>
+#include <mutex>
+
 #include <standardese/markup/block.hpp>
+#include <standardese/markup/link.hpp>
 #include <standardese/markup/phrasing.hpp>
 
 namespace standardese
 {
 namespace markup
 {
+    /// A block of source code.
+    ///
+    /// It can either store its content as a sequence of child entities,
+    /// or in a compact form, as one string containing the whole code,
+    /// together with an array of tokens that refer to parts of it.
+    /// The compact form is used for the synopsis,
+    /// as it doesn't need a separate entity for each token.
     class code_block final : public block_entity, public container_entity<phrasing_entity>
     {
         template <class Tag>
@@ -123,6 +134,108 @@ namespace markup
             {}
         };
 
+        /// The kind of a token of a compact code block.
+        ///
+        /// Except for `text`, `soft_break` and `link`,
+        /// they correspond to the syntax highlighting entities.
+        enum class token_kind : std::uint8_t
+        {
+            text,
+            keyword,
+            identifier,
+            string_literal,
+            int_literal,
+            float_literal,
+            punctuation,
+            preprocessor,
+            soft_break, //< The text is a newline.
+            link,       //< An identifier that is the content of a documentation link.
+        };
+
+        /// A token of a compact code block.
+        ///
+        /// It refers to a part of the [standardese::markup::code_block::code]() of the block.
+        class token
+        {
+        public:
+            /// \returns The kind of token.
+            token_kind kind() const noexcept
+            {
+                return kind_;
+            }
+
+            /// \returns The offset of the text of the token.
+            std::size_t offset() const noexcept
+            {
+                return offset_;
+            }
+
+            /// \returns The length of the text of the token.
+            std::size_t length() const noexcept
+            {
+                return length_;
+            }
+
+        private:
+            token(token_kind kind, std::uint32_t offset, std::uint32_t length,
+                  std::uint32_t link) noexcept
+            : offset_(offset), length_(length), link_(link), kind_(kind)
+            {}
+
+            std::uint32_t offset_, length_, link_;
+            token_kind    kind_;
+
+            friend code_block;
+        };
+
+        /// Builds a code block in the compact form.
+        class compact_builder
+        {
+        public:
+            /// \effects Creates an empty code block.
+            compact_builder(block_id id, std::string lang)
+            : result_(new code_block(std::move(id), std::move(lang)))
+            {
+                result_->compact_ = true;
+            }
+
+            /// \effects Adds a token of the given kind with the given text.
+            /// Adjacent `text` tokens are merged.
+            /// \requires `kind` must not be `token_kind::link`.
+            compact_builder& add_token(token_kind kind, const char* str, std::size_t length);
+
+            /// \group add_token
+            compact_builder& add_token(token_kind kind, const std::string& str)
+            {
+                return add_token(kind, str.c_str(), str.size());
+            }
+
+            /// \effects Adds a `text` token consisting of the given number of spaces.
+            compact_builder& add_indent(std::size_t level);
+
+            /// \effects Adds a `soft_break` token.
+            compact_builder& add_soft_break()
+            {
+                return add_token(token_kind::soft_break, "\n", 1u);
+            }
+
+            /// \effects Adds a `link` token,
+            /// the given identifier will be the content of the link.
+            compact_builder& add_link(documentation_link::builder link, const char* identifier,
+                                      std::size_t length);
+
+            /// \returns The finished entity.
+            std::unique_ptr<code_block> finish() noexcept
+            {
+                return std::move(result_);
+            }
+
+        private:
+            std::unique_ptr<code_block> result_;
+
+            friend code_block;
+        };
+
         /// \returns A new code block containing only the given string.
         static std::unique_ptr<code_block> build(block_id id, std::string language,
                                                  std::string code)
@@ -138,11 +251,55 @@ namespace markup
             return lang_;
         }
 
+        /// \returns Whether or not the code block has been built in the compact form.
+        bool is_compact() const noexcept
+        {
+            return compact_;
+        }
+
+        /// \returns The entire code of a compact code block.
+        const std::string& code() const noexcept
+        {
+            return code_;
+        }
+
+        /// \returns The tokens of a compact code block.
+        const std::vector<token>& tokens() const noexcept
+        {
+            return tokens_;
+        }
+
+        /// \returns The link of a `link` token.
+        /// \requires `tok` must be a `link` token of this code block.
+        const documentation_link& link(const token& tok) const noexcept
+        {
+            return *link_ptrs_[tok.link_];
+        }
+
+        /// \returns An iterator to the first child entity.
+        /// \notes For a compact code block, the child entities are created on the first call,
+        /// one for each token.
+        /// The link children are the same entities as returned by `link()`.
+        iterator begin() const
+        {
+            return compact_ ? (materialize(), iterator(view_.cbegin()))
+                            : container_entity<phrasing_entity>::begin();
+        }
+
+        /// \returns An iterator one past the last child entity.
+        iterator end() const
+        {
+            return compact_ ? (materialize(), iterator(view_.cend()))
+                            : container_entity<phrasing_entity>::end();
+        }
+
     private:
         code_block(block_id id, std::string lang)
-        : block_entity(std::move(id)), lang_(std::move(lang))
+        : block_entity(std::move(id)), lang_(std::move(lang)), compact_(false)
         {}
 
+        void materialize() const;
+
         entity_kind do_get_kind() const noexcept override;
 
         void do_visit(detail::visitor_callback_t cb, void* mem) const override;
@@ -150,6 +307,15 @@ namespace markup
         std::unique_ptr<entity> do_clone() const override;
 
         std::string lang_;
+
+        // compact form, the links are owned by the view once it has been created
+        std::string                                              code_;
+        std::vector<token>                                       tokens_;
+        std::vector<const documentation_link*>                   link_ptrs_;
+        mutable std::vector<std::unique_ptr<documentation_link>> links_;
+        mutable std::vector<std::unique_ptr<phrasing_entity>>    view_;
+        mutable std::once_flag                                   view_once_;
+        bool                                                     compact_;
     };
 } // namespace markup
 } // namespace standardese
@@ -55,6 +55,16 @@ namespace markup
             return do_clone();
         }
 
+        /// \effects Allocates the memory from the current [standardese::markup::arena_scope](),
+        /// if there is any, and from the heap otherwise.
+        /// \notes Every entity is preceded by `alignof(std::max_align_t)` bytes,
+        /// i.e., usually 16, that store the arena it was allocated in.
+        /// They are needed on the heap as well, so that `operator delete` can tell them apart.
+        static void* operator new(std::size_t size);
+
+        /// \effects Releases memory allocated by `operator new`.
+        static void operator delete(void* memory) noexcept;
+
     protected:
         entity() noexcept = default;
 
@@ -12,6 +12,8 @@
 
 namespace standardese
 {
+class doc_entity;
+
 namespace markup
 {
     /// Base class for all links.
@@ -106,6 +108,13 @@ namespace markup
             /// \effects Creates it giving the unresolved destination only.
             builder(std::string dest) : builder("", std::move(dest)) {}
 
+            /// \effects Creates it giving the unresolved destination and the entity it refers to.
+            /// The entity lets the link be resolved without looking up the destination by name.
+            builder(std::string dest, const doc_entity& target) : builder("", std::move(dest))
+            {
+                peek().target_ = &target;
+            }
+
             /// \effects Creates it giving the title and an internal destination.
             builder(std::string title, block_reference dest) : builder(std::move(title), "")
             {
@@ -132,6 +141,12 @@ namespace markup
             return dest_.optional_value(type_safe::variant_type<markup::url>{});
         }
 
+        /// \returns The entity the link refers to, if it was known when the link was created.
+        type_safe::optional_ref<const doc_entity> target() const noexcept
+        {
+            return type_safe::opt_ref(target_);
+        }
+
         /// \returns The unresolved destination id of the link, if it hasn't been resolved already.
         /// It might have been unresolved on purpose and should render just the content.
         type_safe::optional_ref<const std::string> unresolved_destination() const noexcept
@@ -163,6 +178,7 @@ namespace markup
         {}
 
         mutable type_safe::variant<block_reference, markup::url, std::string> dest_;
+        const doc_entity*                                                     target_ = nullptr;
     };
 } // namespace markup
 } // namespace standardese
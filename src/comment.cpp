@@ -21,8 +21,11 @@ void comment_registry::merge(comment_registry&& other)
 {
     map_.insert(std::make_move_iterator(other.map_.begin()),
                 std::make_move_iterator(other.map_.end()));
-    groups_.insert(std::make_move_iterator(other.groups_.begin()),
-                   std::make_move_iterator(other.groups_.end()));
+    for (auto& group : other.groups_)
+    {
+        auto& entities = groups_[group.first];
+        entities.insert(entities.end(), group.second.begin(), group.second.end());
+    }
     modules_.insert(std::make_move_iterator(other.modules_.begin()),
                     std::make_move_iterator(other.modules_.end()));
 }
@@ -37,7 +40,7 @@ bool comment_registry::register_comment(type_safe::object_ref<const cppast::cpp_
     else
     {
         auto& stored_comment = iter->second;
-        if (stored_comment.brief_section() || !stored_comment.sections().empty())
+        if (stored_comment.has_sections())
             // already have a documentation
             return false;
 
@@ -92,6 +95,46 @@ cppast::diagnostic make_parse_diagnostic(const cppast::cpp_entity&   entity,
     return {ex.what(), make_location(entity, ex), cppast::severity::error};
 }
 
+// Returns the comment documenting an entity whose comment could not be parsed.
+comment::doc_comment make_error_comment(const comment::parse_error& ex)
+{
+    return comment::doc_comment(comment::metadata(),
+                                markup::brief_section::builder()
+                                    .add_child(markup::text::build(
+                                        std::string("(error while parsing comment text: ")
+                                        + ex.what() + ")"))
+                                    .finish(),
+                                {});
+}
+
+// Returns the comment of the entity,
+// but if its markup is only parsed later, parse errors are logged and replaced by an error comment
+// just like the errors of comments that are parsed right away.
+comment::doc_comment recover_parse_errors(const cppast::diagnostic_logger& logger,
+                                          const cppast::cpp_entity&        entity,
+                                          comment::doc_comment             comment)
+{
+    if (!comment.is_deferred())
+        return comment;
+
+    // the metadata is already parsed and stays in the outer comment
+    auto metadata = comment.metadata();
+    auto sections = std::make_shared<const comment::doc_comment>(std::move(comment));
+    return comment::doc_comment(std::move(metadata), [&logger, &entity, sections] {
+        try
+        {
+            sections->brief_section();
+            // shares the parsed sections
+            return clone(*sections);
+        }
+        catch (comment::parse_error& ex)
+        {
+            logger.log("standardese comment", make_parse_diagnostic(entity, ex));
+            return make_error_comment(ex);
+        }
+    });
+}
+
 template <typename... Args>
 cppast::diagnostic make_semantic_diagnostic(const cppast::cpp_entity& entity, Args&&... args)
 {
@@ -179,6 +222,8 @@ void process_inlines(const cppast::diagnostic_logger&            logger,
 
 void file_comment_parser::parse(type_safe::object_ref<const cppast::cpp_file> file) const
 {
+    auto& state = get_thread_state();
+
     // add matched comments
     cppast::visit(*file, [&](const cppast::cpp_entity& entity, const cppast::visitor_info& info) {
         if (info.event == cppast::visitor_info::container_entity_exit)
@@ -188,10 +233,10 @@ void file_comment_parser::parse(type_safe::object_ref<const cppast::cpp_file> fi
         {
             auto register_commented = [&](type_safe::object_ref<const cppast::cpp_entity> e,
                                           comment::doc_comment                            comment) {
-                this->register_commented(e, std::move(comment));
+                file_comment_parser::register_commented(state, e, std::move(comment));
             };
             auto register_uncommented = [&](type_safe::object_ref<const cppast::cpp_entity> e) {
-                this->register_uncommented(e);
+                file_comment_parser::register_uncommented(state, e);
             };
 
             // parse comment
@@ -199,30 +244,20 @@ void file_comment_parser::parse(type_safe::object_ref<const cppast::cpp_file> fi
             try
             {
                 comment = type_safe::copy(entity.comment()).map([&](const std::string& str) {
-                    return comment::parse(comment::parser(config_), str, true);
+                    return cache_.parse(parsers_, str, true);
                 });
             }
             catch (comment::parse_error& ex)
             {
                 logger_->log("standardese comment", make_parse_diagnostic(entity, ex));
-                comment
-                    = comment::parse_result{comment::doc_comment(comment::metadata(),
-                                                                 markup::brief_section::builder()
-                                                                     .add_child(markup::text::build(
-                                                                         std::string(
-                                                                             "(error while parsing "
-                                                                             "comment text: ")
-                                                                         + ex.what() + ")"))
-                                                                     .finish(),
-                                                                 {}),
-                                            type_safe::nullvar,
-                                            {}};
+                comment = comment::parse_result{make_error_comment(ex), type_safe::nullvar, {}};
             }
 
             if (comment && comment.value().comment)
                 // register comment
                 register_commented(type_safe::ref(entity),
-                                   std::move(comment.value().comment.value()));
+                                   recover_parse_errors(*logger_, entity,
+                                                        std::move(comment.value().comment.value())));
             else
                 register_uncommented(type_safe::ref(entity));
 
@@ -242,22 +277,21 @@ void file_comment_parser::parse(type_safe::object_ref<const cppast::cpp_file> fi
               message...));
         };
 
-        auto comment = comment::parse(comment::parser(config_), free.content, false);
+        auto comment = cache_.parse(parsers_, free.content, false);
         if (auto module = comment::get_module(comment.entity))
-        {
-            std::unique_lock<std::mutex> lock(mutex_);
-            if (!registry_.register_comment(module.value(), std::move(comment.comment.value())))
-                log("multiple comments for module '", module.value(), "'");
-        }
+            // modules can be documented in any file, so we can only detect
+            // multiple comments for a module once all files are parsed
+            state.module_comments.push_back(
+                {module.value(), std::move(comment.comment.value()),
+                 cppast::source_location::make_file(file->name(), free.line)});
         else if (auto name = comment::get_remote_entity(comment.entity))
-        {
-            std::unique_lock<std::mutex> lock(mutex_);
-            free_comments_.push_back(std::move(comment));
-        }
+            state.free_comments.push_back(std::move(comment));
         else if (comment::is_file(comment.entity) || config_.free_file_comments())
         {
             // comment for current file
-            if (!register_commented(file, std::move(comment.comment.value())))
+            if (!register_commented(state, file,
+                                    recover_parse_errors(*logger_, *file,
+                                                         std::move(comment.comment.value()))))
                 log("multiple file comments");
         }
         else
@@ -267,14 +301,51 @@ void file_comment_parser::parse(type_safe::object_ref<const cppast::cpp_file> fi
     }
 }
 
+file_comment_parser::thread_state& file_comment_parser::get_thread_state() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto&                       state = threads_[std::this_thread::get_id()];
+    if (!state)
+        state = std::make_unique<thread_state>();
+    return *state;
+}
+
 comment_registry file_comment_parser::finish()
 {
+    merge_thread_states();
     resolve_free_comments();
     if (config_.group_uncommented())
         group_uncommented();
     return std::move(registry_);
 }
 
+void file_comment_parser::merge_thread_states()
+{
+    auto uncommented_count = uncommented_.size();
+    for (auto& thread : threads_)
+        uncommented_count += thread.second->uncommented.size();
+    uncommented_.reserve(uncommented_count);
+
+    for (auto& thread : threads_)
+    {
+        auto& state = *thread.second;
+
+        registry_.merge(std::move(state.registry));
+        uncommented_.insert(std::make_move_iterator(state.uncommented.begin()),
+                            std::make_move_iterator(state.uncommented.end()));
+        free_comments_.insert(free_comments_.end(),
+                              std::make_move_iterator(state.free_comments.begin()),
+                              std::make_move_iterator(state.free_comments.end()));
+
+        for (auto& module : state.module_comments)
+            if (!registry_.register_comment(module.name, std::move(module.comment)))
+                logger_->log("standardese comment",
+                             make_diagnostic(module.location, "multiple comments for module '",
+                                             module.name, "'"));
+    }
+    threads_.clear();
+}
+
 void file_comment_parser::resolve_free_comments()
 {
     // Attach comments that are using the `\entity` command to the entity they're documenting.
@@ -287,14 +358,14 @@ void file_comment_parser::resolve_free_comments()
             auto metadata = free.comment.value().metadata();
 
             // Assign the entire comment block to the first entity found.
-            register_commented(type_safe::ref(*result.first->second),
-                               std::move(free.comment.value()), false);
+            register_commented(registry_, type_safe::ref(*result.first->second),
+                               std::move(free.comment.value()));
 
             // And only the metadata to all the other entities found.
             // TODO: What is an example where this actually happens? This does not show up in our test cases.
             for (auto cur = std::next(result.first); cur != result.second; ++cur)
-                register_commented(type_safe::ref(*cur->second),
-                                   comment::doc_comment(metadata, nullptr, {}), false);
+                register_commented(registry_, type_safe::ref(*cur->second),
+                                   comment::doc_comment(metadata, nullptr, {}));
 
             uncommented_.erase(result.first, result.second);
         }
@@ -388,7 +459,7 @@ void file_comment_parser::group_uncommented()
                 // Do not implicitly assign a group if this member already has one.
                 return;
 
-            if (target_comment.has_value() && (target_comment.value().brief_section().has_value() || !target_comment.value().sections().empty()))
+            if (target_comment.has_value() && target_comment.value().has_sections())
                 // Do not implicitly assign a group if this member already has some comment.
                 return;
 
@@ -401,7 +472,7 @@ void file_comment_parser::group_uncommented()
             comment::metadata metadata;
             metadata.set_group(source_comment.value().metadata().group().value());
 
-            register_commented(type_safe::ref(target), comment::doc_comment(metadata, nullptr, {}), false);
+            register_commented(registry_, type_safe::ref(target), comment::doc_comment(metadata, nullptr, {}));
         };
 
         cppast::visit(*file, [&](const cppast::cpp_entity& entity, const cppast::visitor_info& info) {
@@ -426,19 +497,25 @@ void file_comment_parser::group_uncommented()
     }
 }
 
-bool file_comment_parser::register_commented(type_safe::object_ref<const cppast::cpp_entity> entity,
-                                             comment::doc_comment comment, bool allow_cmd) const
+bool file_comment_parser::register_commented(
+    comment_registry& registry, type_safe::object_ref<const cppast::cpp_entity> entity,
+    comment::doc_comment comment)
 {
-    auto cmd_comment = !comment.brief_section() && comment.sections().empty();
-
-    std::lock_guard<std::mutex> lock(mutex_);
     if (comment.metadata().group())
-        registry_.add_to_group(comment.metadata().group().value().name(), entity);
-    auto result = registry_.register_comment(entity, std::move(comment));
+        registry.add_to_group(comment.metadata().group().value().name(), entity);
+    return registry.register_comment(entity, std::move(comment));
+}
 
-    if (cmd_comment && allow_cmd)
+bool file_comment_parser::register_commented(
+    thread_state& state, type_safe::object_ref<const cppast::cpp_entity> entity,
+    comment::doc_comment comment)
+{
+    auto cmd_comment = !comment.has_sections();
+
+    auto result = register_commented(state.registry, entity, std::move(comment));
+    if (cmd_comment)
         // a pure "command" comment, allow later sections
-        uncommented_.emplace(lookup_unique_name(registry_, *entity), &*entity);
+        state.uncommented.emplace(state.unique_names.lookup_unique_name(*entity), &*entity);
 
     return result;
 }
@@ -556,75 +633,120 @@ std::string get_full_unique_name(const std::string& parent, const cppast::cpp_en
     return result;
 }
 
-template <class Lookup>
-std::string lookup_parent_unique_name(const Lookup& get_comment, const cppast::cpp_entity& e)
+// get the parent whose unique name is part of the unique name of the entity
+type_safe::optional_ref<const cppast::cpp_entity> get_scope_parent(const cppast::cpp_entity& e)
 {
     auto parent = e.parent();
     while (parent && (cppast::is_templated(parent.value()) || cppast::is_friended(parent.value())))
         parent = parent.value().parent();
-    if (!parent)
-        return "";
+    return parent;
+}
 
+// get unique name of the scope formed by parent,
+// lookup_parent gets the unique name of the scope of parent itself
+template <class Lookup, class ParentLookup>
+std::string get_scope_unique_name(const Lookup& get_comment, const ParentLookup& lookup_parent,
+                                  const cppast::cpp_entity& parent)
+{
     // don't need unique name for parents that don't have a scope
     // except for functions or templates, those are fine
-    auto need_name = parent.value().scope_name() || detail::get_function(parent.value())
-                     || detail::get_template(parent.value());
+    auto need_name
+        = parent.scope_name() || detail::get_function(parent) || detail::get_template(parent);
     if (!need_name)
         return "";
 
-    auto result
-        = parent
-              .map([&](const cppast::cpp_entity& p) {
-                  return p.scope_name() || detail::get_function(p) ? get_comment(p)
-                                                                   : type_safe::nullopt;
-              })
-              .map([](const comment::doc_comment& c) { return c.metadata().unique_name(); });
-    if (result)
-        return result.value();
+    if (parent.scope_name() || detail::get_function(parent))
+        if (auto comment = get_comment(parent))
+            if (auto unique_name = comment.value().metadata().unique_name())
+                return unique_name.value();
 
     // parent doesn't have a unique name
-    return get_full_unique_name(lookup_parent_unique_name(get_comment, parent.value()),
-                                parent.value(), get_unique_name(parent.value()));
+    return get_full_unique_name(lookup_parent(parent), parent, get_unique_name(parent));
 }
-} // namespace
 
-void file_comment_parser::register_uncommented(
-    type_safe::object_ref<const cppast::cpp_entity> entity) const
+template <class Lookup>
+std::string lookup_parent_unique_name(const Lookup& get_comment, const cppast::cpp_entity& e)
 {
-    auto unique_name
-        = get_full_unique_name(get_parent_unique_name(*entity), *entity, get_unique_name(*entity));
-
-    std::lock_guard<std::mutex> lock(mutex_);
-    uncommented_.emplace(std::move(unique_name), &*entity);
-}
+    auto parent = get_scope_parent(e);
+    if (!parent)
+        return "";
 
-std::string file_comment_parser::get_parent_unique_name(const cppast::cpp_entity& e) const
-{
-    return lookup_parent_unique_name([&](const cppast::cpp_entity& e) { return get_comment(e); },
-                                     e);
+    return get_scope_unique_name(get_comment,
+                                 [&](const cppast::cpp_entity& p) {
+                                     return lookup_parent_unique_name(get_comment, p);
+                                 },
+                                 parent.value());
 }
 
-std::string standardese::lookup_unique_name(const comment_registry&   registry,
-                                            const cppast::cpp_entity& e)
+// get the unique name of e given the unique name of its parent
+template <class ParentLookup>
+std::string get_entity_unique_name(const comment_registry& registry,
+                                   const ParentLookup& lookup_parent, const cppast::cpp_entity& e)
 {
     auto comment = registry.get_comment(e);
     if (comment && comment.value().metadata().unique_name())
     {
         if (is_relative_unique_name(comment.value().metadata().unique_name().value()))
-        {
-            auto parent = lookup_parent_unique_name([&](const cppast::cpp_entity&
-                                                            e) { return registry.get_comment(e); },
-                                                    e);
-            return get_full_unique_name(parent, e,
+            return get_full_unique_name(lookup_parent(e), e,
                                         comment.value().metadata().unique_name().value().substr(1));
-        }
         else
             return comment.value().metadata().unique_name().value();
     }
 
     // calculate unique name
-    auto parent = lookup_parent_unique_name([&](const cppast::cpp_entity&
-                                                    e) { return registry.get_comment(e); },
-                                            e);
-    return get_full_unique_name(parent, e, get_unique_name(e));
+    return get_full_unique_name(lookup_parent(e), e, get_unique_name(e));
+}
+} // namespace
+
+void file_comment_parser::register_uncommented(
+    thread_state& state, type_safe::object_ref<const cppast::cpp_entity> entity)
+{
+    auto unique_name = get_full_unique_name(state.unique_names.lookup_parent_unique_name(*entity),
+                                            *entity, get_unique_name(*entity));
+    state.uncommented.emplace(std::move(unique_name), &*entity);
+}
+
+std::string standardese::lookup_unique_name(const comment_registry&   registry,
+                                            const cppast::cpp_entity& e)
+{
+    return get_entity_unique_name(registry,
+                                  [&](const cppast::cpp_entity& e) {
+                                      return lookup_parent_unique_name(
+                                          [&](const cppast::cpp_entity& e) {
+                                              return registry.get_comment(e);
+                                          },
+                                          e);
+                                  },
+                                  e);
+}
+
+std::string unique_name_cache::lookup_unique_name(const cppast::cpp_entity& e)
+{
+    return get_entity_unique_name(*registry_,
+                                  [&](const cppast::cpp_entity& e) -> const std::string& {
+                                      return lookup_parent_unique_name(e);
+                                  },
+                                  e);
+}
+
+const std::string& unique_name_cache::lookup_parent_unique_name(const cppast::cpp_entity& e)
+{
+    static const std::string no_parent;
+
+    auto parent = get_scope_parent(e);
+    if (!parent)
+        return no_parent;
+
+    auto iter = scopes_.find(&parent.value());
+    if (iter != scopes_.end())
+        return iter->second;
+
+    // references to the elements are stable, even if computing the name inserts
+    auto name = get_scope_unique_name(
+        [&](const cppast::cpp_entity& e) { return registry_->get_comment(e); },
+        [&](const cppast::cpp_entity& e) -> const std::string& {
+            return lookup_parent_unique_name(e);
+        },
+        parent.value());
+    return scopes_.emplace(&parent.value(), std::move(name)).first->second;
 }
@@ -4,11 +4,11 @@
 
 #include "command_extension.hpp"
 #include "user_data.hpp"
-#include "../../util/enum_values.hpp"
 
 #include <type_traits>
 #include <cassert>
 #include <cstring>
+#include <variant>
 
 #include <cmark-gfm.h>
 #include <cmark-gfm-extension_api.h>
@@ -16,7 +16,7 @@
 namespace standardese::comment::command_extension
 {
 
-command_extension::command_extension(const class config& config, cmark_syntax_extension* extension) : config_(config), extension_(extension)
+command_extension::command_extension(const class config& config, cmark_syntax_extension* extension) : config_(config), recognizer_(config), extension_(extension)
 {
     cmark_syntax_extension_set_get_type_string_func(extension, command_extension::cmark_get_type_string);
     cmark_syntax_extension_set_can_contain_func(extension, command_extension::cmark_can_contain);
@@ -110,7 +110,22 @@ cmark_node* command_extension::cmark_postprocess(cmark_syntax_extension* extensi
 {
     command_extension& self = *static_cast<command_extension*>(cmark_syntax_extension_get_private(extension));
 
-    self.postprocessing = true;
+    // The parser might be reused for another comment after this one has been
+    // postprocessed, so we must not remain in postprocessing mode.
+    struct postprocessing_guard
+    {
+        bool& postprocessing;
+
+        explicit postprocessing_guard(bool& postprocessing) : postprocessing(postprocessing)
+        {
+            postprocessing = true;
+        }
+
+        ~postprocessing_guard()
+        {
+            postprocessing = false;
+        }
+    } guard(self.postprocessing);
 
     return self.postprocess(root);
 }
@@ -514,44 +529,25 @@ bool command_extension::can_contain_command(cmark_node* parent_node)
 
 cmark_node* command_extension::parse_command(cmark_parser* parser, cmark_node* parent_container, unsigned char*& begin, unsigned char* end, int indent)
 {
-    // Try to parse a "command" node into "node".
-    const auto parse_command = [&](const auto command) -> cmark_node* {
-        using type = std::remove_cv_t<decltype(command)>;
-
-        const auto& pattern = config_.get_command_pattern(command);
+    auto match = recognizer_.recognize(reinterpret_cast<const char*>(begin), reinterpret_cast<const char*>(end));
+    if (!match)
+        return nullptr;
 
-        std::match_results<char*> match;
-        if (!std::regex_search(reinterpret_cast<char*>(begin), reinterpret_cast<char*>(end), match, pattern, std::regex_constants::match_continuous))
-            return nullptr;
+    begin += match->length;
 
-        begin += match.length();
+    // We found a command. Create a node for it and store the command type and
+    // its arguments in it. We'll process the arguments later.
+    return std::visit([&](const auto command) -> cmark_node* {
+        using type = std::remove_cv_t<decltype(command)>;
 
-        // We found a match for this command. Create a node for it and store
-        // the command type and the match in it. We'll process the arguments later.
         cmark_node* node = cmark_parser_add_child(parser, parent_container, node_type<type>(), indent);
 
         cmark_node_set_syntax_extension(node, extension_);
         cmark_node_set_string_content(node, nullptr);
-        user_data<type>::set(node, command, std::vector<std::string>(++std::begin(match), std::end(match)));
+        user_data<type>::set(node, command, std::move(match->arguments));
 
         return node;
-    };
-
-    // We inefficiently, try to match every command regex here. This could be
-    // done much more efficiently, e.g., by discarding any leading characters
-    // that fail to produce a partial match. But presumably, constructing the
-    // C++ AST in the first place is the relevant bottleneck anyway.
-    for (const auto command : enum_values<command_type>())
-        if (cmark_node* node = parse_command(command))
-            return node;
-    for (const auto command : enum_values<section_type>())
-        if (cmark_node* node = parse_command(command))
-            return node;
-    for (const auto command : enum_values<inline_type>())
-        if (cmark_node* node = parse_command(command))
-            return node;
-
-    return nullptr;
+    }, match->command);
 }
 
 // Explicitly instantiate templates for the linker.
@@ -14,6 +14,7 @@
 #include <standardese/comment/config.hpp>
 
 #include "../cmark-extension/cmark_extension.hpp"
+#include "command_recognizer.hpp"
 
 namespace standardese::comment::command_extension
 {
@@ -40,6 +41,9 @@ namespace standardese::comment::command_extension
 
         ~command_extension();
 
+        /// Return the recognizer for the commands of the configuration of this extension.
+        const command_recognizer& recognizer() const { return recognizer_; }
+
       private:
         command_extension(const config&, cmark_syntax_extension*);
 
@@ -134,10 +138,13 @@ namespace standardese::comment::command_extension
 
         const comment::config& config_;
 
+        /// Classifies line starts as the commands configured in `config_`.
+        command_recognizer recognizer_;
+
         /// The underlying cmark extension that provides the C interface to this class.
         cmark_syntax_extension* extension_;
 
-        /// Whether the postprocessing has started already.
+        /// Whether the postprocessing of the current comment is in progress.
         /// \see [*cmark_can_contain]() for why we need to keep track of this.
         bool postprocessing = false;
     };
@@ -0,0 +1,233 @@
+// Copyright (C) 2021 Julian Rüth <julian.rueth@fsfe.org>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "command_recognizer.hpp"
+#include "../../util/enum_values.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace standardese::comment::command_extension
+{
+
+namespace
+{
+
+// Return whether `c` is matched by `[[:space:]]`.
+bool is_space(char c)
+{
+    switch (c)
+    {
+    case ' ':
+    case '\t':
+    case '\n':
+    case '\v':
+    case '\f':
+    case '\r':
+        return true;
+    default:
+        return false;
+    }
+}
+
+const char* skip_space(const char* begin, const char* end)
+{
+    while (begin != end && is_space(*begin))
+        ++begin;
+    return begin;
+}
+
+const char* skip_word(const char* begin, const char* end)
+{
+    while (begin != end && !is_space(*begin))
+        ++begin;
+    return begin;
+}
+
+// Return whether there is nothing but whitespace in `[begin, end)`.
+bool is_eol(const char* begin, const char* end)
+{
+    return skip_space(begin, end) == end;
+}
+
+// Return the contents of `[begin, end)` without leading and trailing whitespace.
+std::string trim(const char* begin, const char* end)
+{
+    begin = skip_space(begin, end);
+    while (end != begin && is_space(end[-1]))
+        --end;
+    return std::string(begin, end);
+}
+
+} // namespace
+
+command_recognizer::command_recognizer(const config& config) : command_character_(config.command_character())
+{
+    std::size_t priority = 0;
+
+    const auto add = [&](const auto command, argument_shape shape) {
+        if (config.has_default_command_pattern(command))
+            keywords_.push_back(keyword{config::command_name(command), command, shape, priority});
+        else
+            fallbacks_.push_back(fallback{command, &config.get_command_pattern(command), priority});
+        ++priority;
+    };
+
+    // The shapes must correspond to what config::default_command_pattern() creates.
+    for (const auto command : enum_values<command_type>())
+    {
+        switch (command)
+        {
+        case command_type::end:
+            add(command, argument_shape::eol);
+            break;
+        case command_type::exclude:
+            add(command, argument_shape::exclude);
+            break;
+        case command_type::unique_name:
+        case command_type::output_name:
+        case command_type::module:
+            add(command, argument_shape::word_eol);
+            break;
+        case command_type::output_section:
+        case command_type::entity:
+        case command_type::synopsis:
+            add(command, argument_shape::until_eol);
+            break;
+        case command_type::group:
+            add(command, argument_shape::word_until_eol);
+            break;
+        case command_type::file:
+            add(command, argument_shape::none);
+            break;
+        default:
+            throw std::logic_error("not implemented: unknown command type");
+        }
+    }
+    for (const auto command : enum_values<section_type>())
+        add(command, argument_shape::none);
+    for (const auto command : enum_values<inline_type>())
+        add(command, argument_shape::word);
+
+    std::sort(keywords_.begin(), keywords_.end(), [](const keyword& lhs, const keyword& rhs) { return lhs.name < rhs.name; });
+}
+
+std::optional<command_recognizer::match> command_recognizer::recognize(const char* begin, const char* end) const
+{
+    std::optional<match> recognized;
+    std::size_t priority = fallbacks_.size() + keywords_.size();
+
+    // All default patterns start with the command character followed by the
+    // name of the command, so we can determine the only default pattern that
+    // could possibly match from the name alone.
+    if (begin != end && *begin == command_character_)
+    {
+        const char* name_end = skip_word(begin + 1, end);
+        const std::string_view name(begin + 1, std::size_t(name_end - (begin + 1)));
+
+        const auto candidate = std::lower_bound(keywords_.begin(), keywords_.end(), name, [](const keyword& lhs, std::string_view rhs) { return lhs.name < rhs; });
+        if (candidate != keywords_.end() && candidate->name == name)
+        {
+            if (auto arguments = parse_arguments(candidate->shape, name_end, end))
+            {
+                recognized = match{candidate->command, std::move(arguments->first), std::size_t(arguments->second - begin)};
+                priority = candidate->priority;
+            }
+        }
+    }
+
+    // Custom patterns can match anything, so they need to be tried one by one
+    // but only if they would take precedence over what we found already.
+    for (const auto& fallback : fallbacks_)
+    {
+        if (fallback.priority > priority)
+            break;
+        if (auto match = search(fallback, begin, end))
+            return match;
+    }
+
+    return recognized;
+}
+
+bool command_recognizer::may_contain_metadata(const char* begin, const char* end) const
+{
+    const auto is_section = [](const kind& command) { return std::holds_alternative<section_type>(command); };
+
+    // Custom patterns can match anywhere, so we cannot rule them out cheaply.
+    for (const auto& fallback : fallbacks_)
+        if (!is_section(fallback.command))
+            return true;
+
+    // Commands with default patterns can only start at a command character,
+    // so we try every command character up to the end of its line.
+    for (auto cur = std::find(begin, end, command_character_); cur != end; cur = std::find(cur + 1, end, command_character_))
+    {
+        const auto line_end = std::find_if(cur, end, [](char c) { return c == '\n' || c == '\r'; });
+        if (const auto match = recognize(cur, line_end); match && !is_section(match->command))
+            return true;
+    }
+
+    return false;
+}
+
+std::optional<std::pair<std::vector<std::string>, const char*>> command_recognizer::parse_arguments(argument_shape shape, const char* begin, const char* end)
+{
+    // The input is always a single line, so the `eol` in the default patterns
+    // just means that there is only whitespace left. Note that the default
+    // patterns require the name to be followed by whitespace or the end of
+    // the line.
+    const bool boundary = begin == end || is_space(*begin);
+    if (!boundary)
+        return std::nullopt;
+
+    const char* word_begin = skip_space(begin, end);
+    const char* word_end = skip_word(word_begin, end);
+
+    switch (shape)
+    {
+    case argument_shape::eol:
+        if (!is_eol(begin, end))
+            return std::nullopt;
+        return std::make_pair(std::vector<std::string>{}, end);
+    case argument_shape::exclude:
+    {
+        if (word_begin == word_end)
+            return std::make_pair(std::vector<std::string>{""}, end);
+
+        const std::string mode(word_begin, word_end);
+        if ((mode != "target" && mode != "return") || !is_eol(word_end, end))
+            return std::nullopt;
+        return std::make_pair(std::vector<std::string>{mode}, end);
+    }
+    case argument_shape::word_eol:
+        if (word_begin == word_end || !is_eol(word_end, end))
+            return std::nullopt;
+        return std::make_pair(std::vector<std::string>{std::string(word_begin, word_end)}, end);
+    case argument_shape::until_eol:
+        return std::make_pair(std::vector<std::string>{trim(begin, end)}, end);
+    case argument_shape::word_until_eol:
+        if (word_begin == word_end)
+            return std::nullopt;
+        return std::make_pair(std::vector<std::string>{std::string(word_begin, word_end), trim(word_end, end)}, end);
+    case argument_shape::none:
+        return std::make_pair(std::vector<std::string>{}, word_begin);
+    case argument_shape::word:
+        if (word_begin == word_end)
+            return std::nullopt;
+        return std::make_pair(std::vector<std::string>{std::string(word_begin, word_end)}, skip_space(word_end, end));
+    default:
+        throw std::logic_error("not implemented: unknown argument shape");
+    }
+}
+
+std::optional<command_recognizer::match> command_recognizer::search(const fallback& command, const char* begin, const char* end)
+{
+    std::match_results<const char*> match;
+    if (!std::regex_search(begin, end, match, *command.pattern, std::regex_constants::match_continuous))
+        return std::nullopt;
+
+    return command_recognizer::match{command.command, std::vector<std::string>(++std::begin(match), std::end(match)), std::size_t(match.length())};
+}
+
+}
@@ -0,0 +1,116 @@
+// Copyright (C) 2021 Julian Rüth <julian.rueth@fsfe.org>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef STANDARDESE_COMMENT_COMMAND_EXTENSION_COMMAND_RECOGNIZER_HPP_INCLUDED
+#define STANDARDESE_COMMENT_COMMAND_EXTENSION_COMMAND_RECOGNIZER_HPP_INCLUDED
+
+#include <optional>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include <standardese/comment/commands.hpp>
+#include <standardese/comment/config.hpp>
+
+namespace standardese::comment::command_extension
+{
+    /// Classifies the start of a line as one of the commands of a [standardese::comment::config]().
+    ///
+    /// Commands that use their default pattern, e.g., `\returns`, are
+    /// recognized in a single scan: the command character is followed by a
+    /// name that determines the command and the shape of its arguments.
+    /// Only commands that have been overridden or complemented by custom
+    /// patterns fall back to matching their `std::regex`.
+    class command_recognizer
+    {
+      public:
+        /// The kind of command that was recognized.
+        using kind = std::variant<command_type, section_type, inline_type>;
+
+        /// A command recognized at the start of some input.
+        struct match
+        {
+            /// The command that was found.
+            kind command;
+            /// The arguments of the command, i.e., the capture groups of its pattern.
+            std::vector<std::string> arguments;
+            /// The number of characters that make up the command and its arguments.
+            std::size_t length;
+        };
+
+        /// Create a recognizer for the commands of `config`.
+        explicit command_recognizer(const config&);
+
+        /// Return the command that starts at `begin` in `[begin, end)` if any.
+        /// Where several commands could match, the first one in the order of
+        /// `command_type`, `section_type`, `inline_type` wins.
+        std::optional<match> recognize(const char* begin, const char* end) const;
+
+        /// Return whether the comment `[begin, end)` might contain a command
+        /// that is not a section, i.e., a command that sets metadata such as
+        /// `\exclude` or one that documents another entity such as `\param`.
+        /// This only scans the raw text and does not know about the block
+        /// structure of the comment, so it might report commands that
+        /// CommonMark would not recognize, e.g., in a code block, but it never
+        /// misses any.
+        bool may_contain_metadata(const char* begin, const char* end) const;
+
+      private:
+        /// The shape of the arguments of a command with a default pattern.
+        enum class argument_shape
+        {
+            /// Nothing but the end of the line, e.g., `\end`.
+            eol,
+            /// An optional `target` or `return` keyword, i.e., `\exclude`.
+            exclude,
+            /// A single word up to the end of the line, e.g., `\unique_name`.
+            word_eol,
+            /// The rest of the line, e.g., `\synopsis`.
+            until_eol,
+            /// A word followed by the rest of the line, i.e., `\group`.
+            word_until_eol,
+            /// No arguments, e.g., `\returns`.
+            none,
+            /// A word followed by further text, e.g., `\param`.
+            word,
+        };
+
+        /// A command that is recognized by its default pattern.
+        struct keyword
+        {
+            std::string_view name;
+            kind command;
+            argument_shape shape;
+            /// The position of the command in the order in which commands are tried.
+            std::size_t priority;
+        };
+
+        /// A command that is recognized by a custom pattern.
+        struct fallback
+        {
+            kind command;
+            const std::regex* pattern;
+            std::size_t priority;
+        };
+
+        /// Return the arguments and the length of a command of this `shape`
+        /// whose arguments start at `begin`, or nothing if the arguments are malformed.
+        static std::optional<std::pair<std::vector<std::string>, const char*>> parse_arguments(argument_shape, const char* begin, const char* end);
+
+        /// Return the match for the custom pattern of `command` at `begin` if there is any.
+        static std::optional<match> search(const fallback& command, const char* begin, const char* end);
+
+        char command_character_;
+
+        /// The commands with default patterns sorted by name.
+        std::vector<keyword> keywords_;
+
+        /// The commands with custom patterns in the order in which they are tried.
+        std::vector<fallback> fallbacks_;
+    };
+}
+
+#endif // STANDARDESE_COMMENT_COMMAND_EXTENSION_COMMAND_RECOGNIZER_HPP_INCLUDED
@@ -77,9 +77,14 @@ std::string config::default_command_pattern(char command_character, inline_type
     return prefix + command_name(cmd) + boundary + word;
 }
 
-config::config(const options& options) : free_file_comments_(options.free_file_comments), group_uncommented_(options.group_uncommented)
+config::config(const options& options)
 {
-    const auto pattern = [&](const auto command) {
+    auto data = std::make_shared<config::data>();
+    data->command_character = options.command_character;
+    data->free_file_comments = options.free_file_comments;
+    data->group_uncommented = options.group_uncommented;
+
+    const auto parameters = [&](const auto command) {
         const std::string name = command_name(command);
         const auto fallback = default_command_pattern(options.command_character, command);
 
@@ -89,15 +94,26 @@ config::config(const options& options) : free_file_comments_(options.free_file_c
             if (specification.rfind(name, 0) != std::string::npos)
                 parameters.emplace_back(specification);
 
-        return command_pattern(parameters);
+        return parameters;
     };
 
-    for (const auto command : enum_values<command_type>())
-        special_command_patterns_.emplace_back(pattern(command));
-    for (const auto command : enum_values<section_type>())
-        section_command_patterns_.emplace_back(pattern(command));
-    for (const auto command : enum_values<inline_type>())
-        inline_command_patterns_.emplace_back(pattern(command));
+    for (const auto command : enum_values<command_type>()) {
+        const auto specification = parameters(command);
+        data->special_command_patterns.emplace_back(command_pattern(specification));
+        data->special_command_defaults.push_back(specification.size() == 1);
+    }
+    for (const auto command : enum_values<section_type>()) {
+        const auto specification = parameters(command);
+        data->section_command_patterns.emplace_back(command_pattern(specification));
+        data->section_command_defaults.push_back(specification.size() == 1);
+    }
+    for (const auto command : enum_values<inline_type>()) {
+        const auto specification = parameters(command);
+        data->inline_command_patterns.emplace_back(command_pattern(specification));
+        data->inline_command_defaults.push_back(specification.size() == 1);
+    }
+
+    data_ = std::move(data);
 }
 
 std::regex config::command_pattern(const std::vector<std::string>& options)
@@ -218,17 +234,32 @@ const char* config::command_name(inline_type cmd) {
 
 const std::regex& config::get_command_pattern(command_type cmd) const
 {
-    return special_command_patterns_[unsigned(cmd)];
+    return data_->special_command_patterns[unsigned(cmd)];
 }
 
 const std::regex& config::get_command_pattern(section_type section) const
 {
-    return section_command_patterns_[unsigned(section)];
+    return data_->section_command_patterns[unsigned(section)];
 }
 
 const std::regex& config::get_command_pattern(inline_type type) const
 {
-    return inline_command_patterns_[unsigned(type)];
+    return data_->inline_command_patterns[unsigned(type)];
+}
+
+bool config::has_default_command_pattern(command_type cmd) const
+{
+    return data_->special_command_defaults[unsigned(cmd)];
+}
+
+bool config::has_default_command_pattern(section_type section) const
+{
+    return data_->section_command_defaults[unsigned(section)];
+}
+
+bool config::has_default_command_pattern(inline_type type) const
+{
+    return data_->inline_command_defaults[unsigned(type)];
 }
 
 const char* config::inline_section_name(section_type section) const
@@ -5,12 +5,44 @@
 #include <standardese/comment/doc_comment.hpp>
 
 #include <cassert>
+#include <mutex>
 
+#include <standardese/markup/arena.hpp>
 #include <standardese/markup/entity_kind.hpp>
 
 using namespace standardese;
 using namespace standardese::comment;
 
+struct doc_comment::deferred_sections
+{
+    std::once_flag               once;
+    std::function<doc_comment()> parse;
+    std::unique_ptr<doc_comment> result;
+
+    explicit deferred_sections(std::function<doc_comment()> parse) : parse(std::move(parse)) {}
+};
+
+doc_comment::doc_comment(comment::metadata metadata, std::function<doc_comment()> parse_sections)
+: metadata_(std::move(metadata)),
+  deferred_(std::make_shared<deferred_sections>(std::move(parse_sections)))
+{}
+
+const doc_comment& doc_comment::parsed() const
+{
+    if (!deferred_)
+        return *this;
+
+    std::call_once(deferred_->once, [&] {
+        // the sections live as long as the comment, which can be parsed while generating a
+        // document, they must not keep its arena alive
+        markup::heap_scope heap;
+        deferred_->result.reset(new doc_comment(deferred_->parse()));
+        deferred_->parse = nullptr;
+    });
+    // the result can defer to other sections in turn
+    return deferred_->result->parsed();
+}
+
 doc_comment standardese::comment::merge(metadata data, doc_comment&& other)
 {
     auto& other_data = other.metadata();
@@ -27,7 +59,30 @@ doc_comment standardese::comment::merge(metadata data, doc_comment&& other)
     if (!data.output_section() && other_data.output_section())
         data.set_output_section(other_data.output_section().value());
 
-    return doc_comment(std::move(data), std::move(other.brief_), std::move(other.sections_));
+    doc_comment result(std::move(data), std::move(other.brief_), std::move(other.sections_));
+    result.deferred_ = std::move(other.deferred_);
+    return result;
+}
+
+doc_comment standardese::comment::clone(const doc_comment& comment)
+{
+    if (comment.deferred_)
+    {
+        // the sections are immutable, so the copy can share them
+        doc_comment result(comment.metadata(), nullptr, {});
+        result.deferred_ = comment.deferred_;
+        return result;
+    }
+
+    std::vector<std::unique_ptr<markup::doc_section>> sections;
+    sections.reserve(comment.sections().size());
+    for (auto& sec : comment.sections())
+        sections.push_back(markup::clone(sec));
+
+    return doc_comment(comment.metadata(),
+                       comment.brief_section() ? markup::clone(comment.brief_section().value())
+                                               : nullptr,
+                       std::move(sections));
 }
 
 namespace
@@ -6,12 +6,16 @@
 #include <standardese/comment/parser.hpp>
 
 #include <cassert>
+#include <cctype>
 #include <cstring>
+#include <algorithm>
+#include <functional>
 #include <type_traits>
 
 #include <cmark-gfm-extension_api.h>
 #include <cmark-gfm.h>
 
+#include <standardese/markup/arena.hpp>
 #include <standardese/markup/code_block.hpp>
 #include <standardese/markup/entity_kind.hpp>
 #include <standardese/markup/heading.hpp>
@@ -23,6 +27,7 @@
 
 #include "cmark-extension/cmark_extension.hpp"
 #include "command-extension/command_extension.hpp"
+#include "command-extension/command_recognizer.hpp"
 #include "command-extension/user_data.hpp"
 #include "ignore-html-extension/ignore_html_extension.hpp"
 #include "verbatim-extension/verbatim_extension.hpp"
@@ -31,11 +36,11 @@ using namespace standardese;
 using namespace standardese::comment;
 
 parser::parser(comment::config c)
-: config_(std::move(c)), parser_(cmark_parser_new(CMARK_OPT_SMART))
+: config_(std::move(c)), parser_(cmark_parser_new(CMARK_OPT_SMART)), commands_(nullptr)
 {
     verbatim_extension::verbatim_extension::create(parser_);
     ignore_html_extension::ignore_html_extension::create(parser_);
-    command_extension::command_extension::create(parser_, config_);
+    commands_ = &command_extension::command_extension::create(parser_, config_);
 }
 
 parser::~parser() noexcept
@@ -717,9 +722,8 @@ void add_children(const config& c, Builder& b, bool has_matching_entity, cmark_n
             }
     }
 }
-} // namespace
 
-parse_result comment::parse(const parser& p, const std::string& comment, bool has_matching_entity)
+parse_result parse_markup(const parser& p, const std::string& comment, bool has_matching_entity)
 {
     auto root = read_ast(p, comment);
 
@@ -734,3 +738,121 @@ parse_result comment::parse(const parser& p, const std::string& comment, bool ha
         return parse_result{type_safe::nullopt, std::move(builder.entity),
                             std::move(builder.inlines)};
 }
+
+// Returns whether the markup of the comment can be parsed later,
+// i.e., whether the comment has documentation sections but no metadata and no inline entities,
+// and whether the markup is known to parse without errors.
+bool can_defer_markup(const parser& p, const std::string& comment)
+{
+    auto begin = comment.data();
+    auto end   = begin + comment.size();
+    if (p.commands().recognizer().may_contain_metadata(begin, end))
+        return false;
+
+    // HTML, images and footnotes are rejected when parsing the markup,
+    // so the error must be reported right away
+    if (std::find(begin, end, '<') != end || comment.find("![") != std::string::npos
+        || comment.find("[^") != std::string::npos)
+        return false;
+
+    // there must be a line that is not a command and not a link reference definition,
+    // otherwise there might not be any sections
+    auto command_character = p.config().command_character();
+    for (auto cur = begin; cur != end;)
+    {
+        auto line_end = std::find(cur, end, '\n');
+        auto first    = std::find_if(cur, line_end, [](char c) { return !std::isspace(static_cast<unsigned char>(c)); });
+        if (first != line_end && *first != command_character && *first != '[')
+            return true;
+        cur = line_end == end ? end : line_end + 1;
+    }
+    return false;
+}
+} // namespace
+
+const parser& parser_pool::get() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto&                       p = parsers_[std::this_thread::get_id()];
+    if (!p)
+        p = std::make_unique<parser>(config_);
+    return *p;
+}
+
+parse_result comment::parse(const parser& p, const std::string& comment, bool has_matching_entity)
+{
+    return parse_markup(p, comment, has_matching_entity);
+}
+
+parse_result comment::parse(const std::shared_ptr<const parser_pool>& parsers,
+                            const std::string& comment, bool has_matching_entity)
+{
+    auto& p = parsers->get();
+    if (!can_defer_markup(p, comment))
+        return parse_markup(p, comment, has_matching_entity);
+
+    // the pool is kept alive by the comment, so the thread accessing the sections can use it
+    auto parse_sections = [parsers, comment, has_matching_entity] {
+        auto result = parse_markup(parsers->get(), comment, has_matching_entity);
+        assert(result.inlines.empty());
+        if (!result.comment)
+            return doc_comment(metadata(), nullptr, {});
+        return std::move(result.comment.value());
+    };
+    return parse_result{doc_comment(metadata(), std::move(parse_sections)), matching_entity(), {}};
+}
+
+parse_result comment::clone(const parse_result& result)
+{
+    std::vector<unmatched_doc_comment> inlines;
+    inlines.reserve(result.inlines.size());
+    for (auto& inl : result.inlines)
+        inlines.emplace_back(inl.entity, clone(inl.comment));
+
+    return parse_result{result.comment.map([](const doc_comment& c) { return clone(c); }),
+                        result.entity, std::move(inlines)};
+}
+
+std::size_t parse_cache::key_hash::operator()(const key& k) const noexcept
+{
+    auto hash = std::hash<std::string>{}(k.text);
+    hash ^= std::hash<const void*>{}(k.config.identity()) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    return hash ^ std::size_t(k.has_matching_entity);
+}
+
+parse_result parse_cache::parse(const std::shared_ptr<const parser_pool>& parsers,
+                                const std::string& comment, bool has_matching_entity)
+{
+    key  k{comment, parsers->config(), has_matching_entity};
+    auto hash   = key_hash{}(k);
+    auto& shard = shards_[hash % shard_count];
+
+    auto repeated = false;
+    {
+        std::unique_lock<std::mutex> lock(shard.mutex);
+        auto                         iter = shard.results.find(k);
+        if (iter != shard.results.end())
+        {
+            // the entries are never removed, so we can copy them without holding the lock
+            auto& cached = iter->second;
+            lock.unlock();
+
+            ++hits_;
+            return clone(cached);
+        }
+
+        repeated = !shard.seen.insert(hash).second;
+    }
+
+    ++misses_;
+    auto result = comment::parse(parsers, comment, has_matching_entity);
+    if (!repeated)
+        // most texts are unique, keeping a copy of each would double the memory
+        return result;
+
+    // the cached copy lives as long as the cache
+    markup::heap_scope          heap;
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.results.emplace(std::move(k), clone(result));
+    return result;
+}
@@ -64,7 +64,7 @@ doc_excluded_entity parent_excluded_entity;
 /// Return whether this comment provides meaningful documentation.
 bool is_documenting(const comment::doc_comment& comment)
 {
-    return comment.brief_section() || !comment.sections().empty();
+    return comment.has_sections();
 }
 
 /// Return whether this entity has meaningful documentation.
@@ -355,19 +355,21 @@ private:
     void do_write_token_seq(cppast::string_view tokens) override
     {
         update_indent();
-        builder_.add_child(markup::text::build(tokens.c_str()));
+        builder_.add_token(markup::code_block::token_kind::text, tokens.c_str(), tokens.length());
     }
 
     void do_write_keyword(cppast::string_view keyword) override
     {
         update_indent();
-        builder_.add_child(markup::code_block::keyword::build(keyword.c_str()));
+        builder_.add_token(markup::code_block::token_kind::keyword, keyword.c_str(),
+                           keyword.length());
     }
 
     void write_identifier(cppast::string_view identifier)
     {
         if (identifier.length() > 0u)
-            builder_.add_child(markup::code_block::identifier::build(identifier.c_str()));
+            builder_.add_token(markup::code_block::token_kind::identifier, identifier.c_str(),
+                               identifier.length());
     }
 
     bool write_link(const doc_entity& entity, cppast::string_view name)
@@ -375,9 +377,9 @@ private:
         if (is_documented(entity))
         {
             // only generate link if the entity has actual documentation
-            markup::documentation_link::builder link(entity.link_name());
-            link.add_child(markup::code_block::identifier::build(name.c_str()));
-            builder_.add_child(link.finish());
+            // the linker can resolve the link by the entity instead of its name
+            builder_.add_link(markup::documentation_link::builder(entity.link_name(), entity),
+                              name.c_str(), name.length());
         }
         else if (entity.is_excluded())
         {
@@ -429,37 +431,41 @@ private:
     void do_write_punctuation(cppast::string_view punct) override
     {
         update_indent();
-        builder_.add_child(markup::code_block::punctuation::build(punct.c_str()));
+        builder_.add_token(markup::code_block::token_kind::punctuation, punct.c_str(),
+                           punct.length());
     }
 
     void do_write_str_literal(cppast::string_view str) override
     {
         update_indent();
-        builder_.add_child(markup::code_block::string_literal::build(str.c_str()));
+        builder_.add_token(markup::code_block::token_kind::string_literal, str.c_str(),
+                           str.length());
     }
 
     void do_write_int_literal(cppast::string_view str) override
     {
         update_indent();
-        builder_.add_child(markup::code_block::int_literal::build(str.c_str()));
+        builder_.add_token(markup::code_block::token_kind::int_literal, str.c_str(), str.length());
     }
 
     void do_write_float_literal(cppast::string_view str) override
     {
         update_indent();
-        builder_.add_child(markup::code_block::float_literal::build(str.c_str()));
+        builder_.add_token(markup::code_block::token_kind::float_literal, str.c_str(),
+                           str.length());
     }
 
     void do_write_preprocessor(cppast::string_view punct) override
     {
         update_indent();
-        builder_.add_child(markup::code_block::preprocessor::build(punct.c_str()));
+        builder_.add_token(markup::code_block::token_kind::preprocessor, punct.c_str(),
+                           punct.length());
     }
 
     void write_excluded()
     {
         update_indent();
-        builder_.add_child(markup::code_block::identifier::build(config_->hidden_name()));
+        builder_.add_token(markup::code_block::token_kind::identifier, config_->hidden_name());
     }
 
     void do_write_excluded(const cppast::cpp_entity&) override
@@ -469,26 +475,26 @@ private:
 
     void do_write_newline() override
     {
-        builder_.add_child(markup::soft_break::build());
+        builder_.add_soft_break();
         need_indent_.set();
     }
 
     void do_write_whitespace() override
     {
         update_indent();
-        builder_.add_child(markup::text::build(" "));
+        builder_.add_token(markup::code_block::token_kind::text, " ", 1u);
     }
 
     void update_indent()
     {
         if (need_indent_.try_reset())
-            builder_.add_child(markup::text::build(std::string(level_, ' ')));
+            builder_.add_indent(level_);
     }
 
     type_safe::object_ref<const synopsis_config>          config_;
     type_safe::object_ref<const cppast::cpp_entity_index> index_;
 
-    markup::code_block::builder builder_;
+    markup::code_block::compact_builder builder_;
 
     std::stack<type_safe::object_ref<const cppast::cpp_entity>> entities_;
 
@@ -1208,6 +1214,7 @@ bool is_ignored(const cppast::cpp_entity& e)
 }
 
 std::unique_ptr<doc_entity> build_entity(const comment_registry&         registry,
+                                         unique_name_cache&              unique_names,
                                          const cppast::cpp_entity_index& index,
                                          const cppast::cpp_entity&       e);
 
@@ -1261,14 +1268,15 @@ void handle_bases(const Visitor& visitor, const comment_registry& registry,
 }
 
 std::unique_ptr<doc_cpp_entity> build_cpp_entity(const comment_registry&         registry,
+                                                 unique_name_cache&              unique_names,
                                                  const cppast::cpp_entity_index& index,
                                                  const cppast::cpp_entity&       e)
 {
-    auto                    link_name = lookup_unique_name(registry, e);
+    auto                    link_name = unique_names.lookup_unique_name(e);
     doc_cpp_entity::builder builder(link_name, type_safe::ref(e), registry.get_comment(e));
 
     auto visitor = [&](const cppast::cpp_entity& entity, bool injected) {
-        if (auto child = build_entity(registry, index, entity))
+        if (auto child = build_entity(registry, unique_names, index, entity))
         {
             if (injected)
                 child->mark_injected();
@@ -1295,6 +1303,7 @@ std::unique_ptr<doc_cpp_entity> build_cpp_entity(const comment_registry&
 }
 
 std::unique_ptr<doc_metadata_entity> build_metadata_entity(const comment_registry&         registry,
+                                                           unique_name_cache&              unique_names,
                                                            const cppast::cpp_entity_index& index,
                                                            const cppast::cpp_entity&       e)
 {
@@ -1304,13 +1313,14 @@ std::unique_ptr<doc_metadata_entity> build_metadata_entity(const comment_registr
 
     doc_metadata_entity::builder builder(type_safe::ref(e), type_safe::ref(comment.value()));
     detail::visit_children(e, [&](const cppast::cpp_entity& entity) {
-        if (auto child = build_entity(registry, index, entity))
+        if (auto child = build_entity(registry, unique_names, index, entity))
             builder.add_child(std::move(child));
     });
     return builder.finish();
 }
 
 std::unique_ptr<doc_member_group_entity> build_member_group(const comment_registry& registry,
+                                                            unique_name_cache&      unique_names,
                                                             const cppast::cpp_entity_index& index,
                                                             const std::string&        group_name,
                                                             const cppast::cpp_entity& e)
@@ -1334,20 +1344,21 @@ std::unique_ptr<doc_member_group_entity> build_member_group(const comment_regist
         // e is the main entity, so build group
         doc_member_group_entity::builder builder(group_name);
         for (auto& member : group)
-            builder.add_member(build_cpp_entity(registry, index, *member));
+            builder.add_member(build_cpp_entity(registry, unique_names, index, *member));
         return builder.finish();
     }
 }
 
 std::unique_ptr<doc_cpp_namespace> build_namespace(const comment_registry&         registry,
+                                                   unique_name_cache&              unique_names,
                                                    const cppast::cpp_entity_index& index,
                                                    const cppast::cpp_namespace&    ns)
 {
-    doc_cpp_namespace::builder builder(lookup_unique_name(registry, ns), type_safe::ref(ns),
+    doc_cpp_namespace::builder builder(unique_names.lookup_unique_name(ns), type_safe::ref(ns),
                                        registry.get_comment(ns));
 
     detail::visit_children(ns, [&](const cppast::cpp_entity& entity) {
-        if (auto child = build_entity(registry, index, entity))
+        if (auto child = build_entity(registry, unique_names, index, entity))
             builder.add_child(std::move(child));
     });
 
@@ -1381,6 +1392,7 @@ bool build_is_excluded(const cppast::cpp_entity_index& index, const cppast::cpp_
 }
 
 std::unique_ptr<doc_entity> build_entity(const comment_registry&         registry,
+                                         unique_name_cache&              unique_names,
                                          const cppast::cpp_entity_index& index,
                                          const cppast::cpp_entity&       e)
 {
@@ -1389,14 +1401,14 @@ std::unique_ptr<doc_entity> build_entity(const comment_registry&         registr
         return nullptr;
     else if (is_ignored(e) || (e.kind() == cppast::cpp_friend::kind() && !is_friend_func_def(e)))
         // those can only be documented as metadata
-        return build_metadata_entity(registry, index, e);
+        return build_metadata_entity(registry, unique_names, index, e);
     else if (e.kind() == cppast::cpp_namespace::kind())
-        return build_namespace(registry, index, static_cast<const cppast::cpp_namespace&>(e));
+        return build_namespace(registry, unique_names, index, static_cast<const cppast::cpp_namespace&>(e));
     else if (comment.has_value() && comment.value().metadata().group())
-        return build_member_group(registry, index,
+        return build_member_group(registry, unique_names, index,
                                   comment.value().metadata().group().value().name(), e);
     else
-        return build_cpp_entity(registry, index, e);
+        return build_cpp_entity(registry, unique_names, index, e);
 }
 } // namespace
 
@@ -1446,11 +1458,14 @@ std::unique_ptr<doc_cpp_file> standardese::build_doc_entities(
     if (comment && comment.value().metadata().output_name())
         output_name = comment.value().metadata().output_name().value();
 
-    doc_cpp_file::builder builder(std::move(output_name), lookup_unique_name(*registry, f),
+    // the entities of a file are nested, so share the unique names of their parents
+    unique_name_cache unique_names(*registry);
+
+    doc_cpp_file::builder builder(std::move(output_name), unique_names.lookup_unique_name(f),
                                   std::move(file), comment);
 
     detail::visit_children(f, [&](const cppast::cpp_entity& entity) {
-        if (auto child = build_entity(*registry, index, entity))
+        if (auto child = build_entity(*registry, unique_names, index, entity))
             builder.add_child(std::move(child));
     });
 
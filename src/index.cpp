@@ -6,6 +6,8 @@
 
 #include <algorithm>
 #include <cassert>
+#include <iterator>
+#include <string_view>
 #include <cppast/cpp_file.hpp>
 #include <cppast/cpp_namespace.hpp>
 #include <cppast/cpp_preprocessor.hpp>
@@ -24,38 +26,37 @@ using namespace standardese;
 
 void entity_index::insert(entity e) const
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto                        range
-        = std::equal_range(entities_.begin(), entities_.end(), e,
-                           [](const entity_index::entity& lhs, const entity_index::entity& rhs) {
-                               return lhs.scope + lhs.name < rhs.scope + rhs.name;
-                           });
-    if (range.first == range.second)
-        entities_.insert(range.first, std::move(e));
-    else
-    {
-        assert(std::next(range.first) == range.second);
-        auto& inserted = *range.first;
-        if (auto builder = inserted.doc.optional_value(
-                type_safe::variant_type<markup::namespace_documentation::builder>{}))
-        {
-            auto& e_builder
-                = e.doc.value(type_safe::variant_type<markup::namespace_documentation::builder>{});
-            if (!builder.value().has_documentation() && e_builder.has_documentation())
-                inserted.doc = std::move(e.doc);
-        }
-    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    // the bucket of a thread is only used by that thread and never moves
+    auto& bucket = buckets_[std::this_thread::get_id()];
+    e.sequence   = next_sequence_++;
+    lock.unlock();
+
+    bucket.push_back(std::move(e));
 }
 
 namespace
 {
+std::unique_ptr<markup::documentation_link> get_entity_link(
+    const std::string& name, std::string link_name, type_safe::optional_ref<const doc_entity> target)
+{
+    if (target)
+        // the linker can resolve the link without looking up the name
+        return markup::documentation_link::builder(std::move(link_name), target.value())
+            .add_child(markup::code::build(name))
+            .finish();
+    else
+        return markup::documentation_link::builder(std::move(link_name))
+            .add_child(markup::code::build(name))
+            .finish();
+}
+
 std::unique_ptr<markup::entity_index_item> get_entity_entry(
     const std::string& name, std::string link_name,
-    type_safe::optional_ref<const markup::brief_section> brief)
+    type_safe::optional_ref<const markup::brief_section> brief,
+    type_safe::optional_ref<const doc_entity>            target = nullptr)
 {
-    auto link = markup::documentation_link::builder(link_name)
-                    .add_child(markup::code::build(name))
-                    .finish();
+    auto link = get_entity_link(name, link_name, target);
     auto term = markup::term::build(std::move(link));
 
     if (brief)
@@ -89,8 +90,10 @@ void entity_index::register_entity(std::string link_name, const cppast::cpp_enti
 {
     assert(e.kind() != cppast::cpp_file::kind() && e.kind() != cppast::cpp_namespace::kind());
     if (e.kind() != cppast::cpp_include_directive::kind()) // don't insert includes
-        insert(entity(get_entity_entry(e.name(), std::move(link_name), brief), e.name(),
-                      get_scope(e)));
+        insert(entity(get_entity_entry(e.name(), std::move(link_name), brief,
+                                       type_safe::opt_ref(
+                                           static_cast<const doc_entity*>(e.user_data()))),
+                      e.name(), get_scope(e)));
 }
 
 void entity_index::register_namespace(const cppast::cpp_namespace&             ns,
@@ -152,18 +155,92 @@ struct nested_list_builder
         type_safe::with(builder, lambda{}, std::move(item));
     }
 };
+
+// compares `lhs_scope + lhs_name` with `rhs_scope + rhs_name` without concatenating them
+int compare_qualified(std::string_view lhs_scope, std::string_view lhs_name,
+                      std::string_view rhs_scope, std::string_view rhs_name)
+{
+    std::string_view lhs[] = {lhs_scope, lhs_name};
+    std::string_view rhs[] = {rhs_scope, rhs_name};
+
+    auto lhs_i = 0u, rhs_i = 0u;
+    while (true)
+    {
+        while (lhs_i != 2u && lhs[lhs_i].empty())
+            ++lhs_i;
+        while (rhs_i != 2u && rhs[rhs_i].empty())
+            ++rhs_i;
+        if (lhs_i == 2u || rhs_i == 2u)
+            return int(rhs_i == 2u) - int(lhs_i == 2u);
+
+        // compare as much as both current segments have
+        auto length = std::min(lhs[lhs_i].size(), rhs[rhs_i].size());
+        if (auto result = lhs[lhs_i].substr(0, length).compare(rhs[rhs_i].substr(0, length)))
+            return result;
+        lhs[lhs_i].remove_prefix(length);
+        rhs[rhs_i].remove_prefix(length);
+    }
+}
+
+bool is_same_entity(const std::string& lhs_scope, const std::string& lhs_name,
+                    const std::string& rhs_scope, const std::string& rhs_name)
+{
+    return compare_qualified(lhs_scope, lhs_name, rhs_scope, rhs_name) == 0;
+}
 } // namespace
 
 std::unique_ptr<markup::entity_index> entity_index::generate(order o) const
 {
+    std::unique_lock<std::mutex> lock(mutex_);
+    std::vector<entity>          entities;
+    {
+        auto size = std::size_t(0);
+        for (auto& bucket : buckets_)
+            size += bucket.second.size();
+        entities.reserve(size);
+    }
+    for (auto& bucket : buckets_)
+        std::move(bucket.second.begin(), bucket.second.end(), std::back_inserter(entities));
+    buckets_.clear();
+    lock.unlock();
+
+    // sort by scope, then name,
+    // duplicates in the order of registration, as the order of the buckets is arbitrary
+    std::sort(entities.begin(), entities.end(), [](const entity& lhs, const entity& rhs) {
+        auto result = compare_qualified(lhs.scope, lhs.name, rhs.scope, rhs.name);
+        return result != 0 ? result < 0 : lhs.sequence < rhs.sequence;
+    });
+
+    // merge duplicates, only a namespace can gain documentation by a later registration
+    auto last = entities.begin(); // one past the last distinct entity
+    for (auto cur = entities.begin(); cur != entities.end(); ++cur)
+    {
+        if (last == entities.begin()
+            || !is_same_entity(std::prev(last)->scope, std::prev(last)->name, cur->scope,
+                               cur->name))
+        {
+            if (last != cur)
+                *last = std::move(*cur);
+            ++last;
+        }
+        else if (auto builder = std::prev(last)->doc.optional_value(
+                     type_safe::variant_type<markup::namespace_documentation::builder>{}))
+        {
+            auto& cur_builder
+                = cur->doc.value(type_safe::variant_type<markup::namespace_documentation::builder>{});
+            if (!builder.value().has_documentation() && cur_builder.has_documentation())
+                std::prev(last)->doc = std::move(cur->doc);
+        }
+    }
+    entities.erase(last, entities.end());
+
     markup::entity_index::builder builder(
         markup::heading::build(markup::block_id(), "Project index"));
 
     std::vector<nested_list_builder> lists;
     lists.push_back(nested_list_builder{"", type_safe::ref(builder)});
 
-    std::unique_lock<std::mutex> lock(mutex_);
-    for (auto& entity : entities_)
+    for (auto& entity : entities)
     {
         // find matching parent
         while (entity.scope != (lists.back().scope.empty() ? "" : lists.back().scope + "::"))
@@ -182,7 +259,6 @@ std::unique_ptr<markup::entity_index> entity_index::generate(order o) const
             lists.back().add_item(std::move(entity.doc.value(
                 type_safe::variant_type<std::unique_ptr<markup::entity_index_item>>{})));
     }
-    lock.unlock();
 
     while (!lists.empty())
     {
@@ -272,7 +348,9 @@ bool module_index::register_entity(std::string module, std::string link_name,
                                     const std::string& rhs) { return lhs.id().as_str() < rhs; });
     if (iter == modules_.end() || iter->id().as_str() != module)
         return false;
-    iter->add_child(get_entity_entry(entity.name(), std::move(link_name), std::move(brief)));
+    iter->add_child(
+        get_entity_entry(entity.name(), std::move(link_name), std::move(brief),
+                         type_safe::opt_ref(static_cast<const doc_entity*>(entity.user_data()))));
     return true;
 }
 
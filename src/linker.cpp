@@ -6,6 +6,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <iterator>
 
 #include <cppast/cpp_entity.hpp>
 #include <cppast/cpp_file.hpp>
@@ -106,6 +107,8 @@ bool linker::register_documentation(std::string link_name, const markup::documen
     auto short_name = short_link_name(link_name);
 
     std::lock_guard<std::mutex> lock(mutex_);
+    if (frozen_)
+        throw std::logic_error("cannot register documentation in a frozen linker");
 
     // insert long name
     auto result = map_.emplace(std::move(link_name), ref);
@@ -163,35 +166,227 @@ std::string get_scope_name(const cppast::cpp_entity& entity)
     auto scope_name = scope.map(&cppast::cpp_scope_name::name);
     return type_safe::copy(scope_name).value_or("");
 }
+} // namespace
 
-std::string get_entity_scope(const cppast::cpp_entity& entity)
+linker::scope_chain::scope_chain(type_safe::optional_ref<const cppast::cpp_entity> context)
 {
-    std::string result;
-    for (auto cur = entity.parent(); cur; cur = cur.value().parent())
+    if (!context)
+        return;
+
+    // the scope of an entity consists of the names of all its parents,
+    // so the scope of each parent is a prefix of the scope of the context
+    std::vector<std::string> names;
+    for (auto cur = context.value().parent(); cur; cur = cur.value().parent())
+    {
+        auto name = get_scope_name(cur.value());
+        if (!name.empty())
+        {
+            // spaces are not part of link names
+            name.erase(std::remove(name.begin(), name.end(), ' '), name.end());
+            name += "::";
+        }
+        names.push_back(std::move(name));
+    }
+
+    for (auto iter = names.rbegin(); iter != names.rend(); ++iter)
+        scope_ += *iter;
+
+    lengths_.push_back(scope_.size());
+    for (auto& name : names)
     {
-        auto cur_scope = get_scope_name(cur.value());
-        if (!cur_scope.empty())
-            result = cur_scope + "::" + result;
+        auto length = lengths_.back() - name.size();
+        if (length != lengths_.back())
+            // the same scope needs to be tried only once
+            lengths_.push_back(length);
     }
-    return result;
 }
-} // namespace
+
+void linker::scope_chain::set_context(type_safe::optional_ref<const cppast::cpp_entity> context)
+{
+    scope_chain other(context);
+    if (other.scope_ == scope_ && other.lengths_ == lengths_)
+        return;
+
+    scope_   = std::move(other.scope_);
+    lengths_ = std::move(other.lengths_);
+    current_ = nullptr;
+}
+
+linker::frozen_map::frozen_map(std::unordered_map<std::string, markup::block_reference>&& map)
+{
+    entries_.reserve(map.size());
+    for (auto& pair : map)
+        entries_.push_back({std::hash<std::string_view>{}(pair.first), pair.first,
+                            std::move(pair.second)});
+
+    // at most half of the slots are used, so the probe sequences stay short
+    auto no_slots = std::size_t(1);
+    while (no_slots < 2 * entries_.size())
+        no_slots *= 2;
+    slots_.assign(no_slots, 0u);
+
+    for (auto i = std::size_t(0); i != entries_.size(); ++i)
+    {
+        auto slot = entries_[i].hash & (no_slots - 1);
+        while (slots_[slot] != 0u)
+            slot = (slot + 1) & (no_slots - 1);
+        slots_[slot] = std::uint32_t(i + 1);
+    }
+}
+
+const markup::block_reference* linker::frozen_map::lookup(std::string_view name) const noexcept
+{
+    auto hash = std::hash<std::string_view>{}(name);
+    for (auto slot = hash & (slots_.size() - 1); slots_[slot] != 0u;
+         slot      = (slot + 1) & (slots_.size() - 1))
+    {
+        auto& entry = entries_[slots_[slot] - 1];
+        if (entry.hash == hash && entry.name == name)
+            return &entry.reference;
+    }
+    return nullptr;
+}
+
+void linker::register_entity(const doc_entity& entity) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (frozen_)
+        throw std::logic_error("cannot register entity in a frozen linker");
+    entities_.emplace(&entity, entity.link_name());
+}
+
+void linker::freeze()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (frozen_)
+        return;
+
+    frozen_map_ = frozen_map(std::move(map_));
+    map_.clear();
+    frozen_         = true;
+    shared_results_ = std::make_shared<const result_map>();
+
+    // each entity is resolved once, instead of once per link to it
+    entity_results_.reserve(entities_.size());
+    for (auto& entity : entities_)
+        if (!is_relative(entity.second))
+            entity_results_.emplace(entity.first, resolve(scope_chain(nullptr), false,
+                                                          process_link_name(entity.second)));
+    entities_.clear();
+}
+
+type_safe::optional<markup::block_reference> linker::do_lookup(std::string_view link_name) const
+{
+    if (frozen_)
+    {
+        // no more registrations, so no need to lock
+        if (auto result = frozen_map_.lookup(link_name))
+            return *result;
+        return type_safe::nullopt;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto                        iter = map_.find(std::string(link_name));
+    if (iter == map_.end())
+        return type_safe::nullopt;
+    return iter->second;
+}
 
 type_safe::variant<type_safe::nullvar_t, markup::block_reference, markup::url> linker::
     lookup_documentation(type_safe::optional_ref<const cppast::cpp_entity> context,
                          std::string                                       link_name) const
+{
+    // a single lookup, so there is nothing worth remembering
+    auto relative = is_relative(link_name);
+    return resolve(scope_chain(relative ? context : nullptr), relative,
+                   process_link_name(std::move(link_name)));
+}
+
+type_safe::variant<type_safe::nullvar_t, markup::block_reference, markup::url> linker::
+    lookup_documentation(const scope_chain& scopes, std::string link_name) const
 {
     auto relative = is_relative(link_name);
     link_name     = process_link_name(std::move(link_name));
+    if (!frozen_)
+        // the result might still change with later registrations
+        return resolve(scopes, relative, std::move(link_name));
+
+    if (!scopes.shared_)
+        // the shared results are only loaded once per chain
+        scopes.shared_ = std::atomic_load(&shared_results_);
+    if (!relative)
+    {
+        auto iter = scopes.shared_->find(link_name);
+        if (iter != scopes.shared_->end())
+        {
+            ++scopes.cache_hits_;
+            return iter->second;
+        }
+    }
+    else if (!scopes.current_)
+        scopes.current_ = &scopes.relative_[{scopes.scope_, scopes.lengths_}];
 
-    // performs local lookup
-    auto do_lookup = [&](const std::string& link_name)
-        -> type_safe::variant<type_safe::nullvar_t, markup::block_reference, markup::url> {
-        std::lock_guard<std::mutex> lock(mutex_);
-        auto                        iter = map_.find(process_link_name(link_name));
-        if (iter == map_.end())
-            return type_safe::nullvar;
+    auto& results = relative ? *scopes.current_ : scopes.absolute_;
+    auto  iter    = results.find(link_name);
+    if (iter != results.end())
+    {
+        ++scopes.cache_hits_;
         return iter->second;
+    }
+
+    ++scopes.cache_misses_;
+    auto result = resolve(scopes, relative, link_name);
+    results.emplace(std::move(link_name), result);
+    return result;
+}
+
+void linker::merge_results(scope_chain& scopes) const
+{
+    cache_hits_ += scopes.cache_hits_;
+    cache_misses_ += scopes.cache_misses_;
+    scopes.cache_hits_   = 0u;
+    scopes.cache_misses_ = 0u;
+    if (scopes.absolute_.empty())
+        return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& result : scopes.absolute_)
+        pending_results_.insert(std::move(result));
+    scopes.absolute_.clear();
+
+    // the shared results are copied for every update,
+    // so only do it once there are enough new ones to pay for the copy
+    auto shared = std::atomic_load(&shared_results_);
+    if (pending_results_.size() * 4u < shared->size())
+        return;
+
+    auto merged = std::make_shared<result_map>(*shared);
+    merged->insert(std::make_move_iterator(pending_results_.begin()),
+                   std::make_move_iterator(pending_results_.end()));
+    pending_results_.clear();
+    std::atomic_store(&shared_results_, std::shared_ptr<const result_map>(std::move(merged)));
+}
+
+type_safe::variant<type_safe::nullvar_t, markup::block_reference, markup::url> linker::
+    lookup_documentation(const doc_entity& entity) const
+{
+    if (frozen_)
+    {
+        auto iter = entity_results_.find(&entity);
+        if (iter != entity_results_.end())
+            return iter->second;
+    }
+
+    return lookup_documentation(nullptr, entity.link_name());
+}
+
+linker::lookup_result linker::resolve(const scope_chain& scopes, bool relative,
+                                      std::string link_name) const
+{
+    auto to_result = [](type_safe::optional<markup::block_reference> ref) -> lookup_result {
+        if (ref)
+            return ref.value();
+        return type_safe::nullvar;
     };
 
     auto external_iter = external_doc_.lower_bound(link_name);
@@ -204,17 +399,28 @@ type_safe::variant<type_safe::nullvar_t, markup::block_reference, markup::url> l
     }
     else if (!relative)
         // absolute lookup
-        return do_lookup(link_name);
+        return to_result(do_lookup(process_link_name(link_name)));
+    else if (scopes.lengths_.empty())
+        // no context
+        return type_safe::nullvar;
     else
     {
-        // relative lookup
-        while (context)
+        // relative lookup, in the scope of the context and then in the scopes of its parents,
+        // the scopes get shorter, so a single buffer is enough
+        auto unscoped = process_link_name(link_name);
+        if (link_name.size() >= 2u && link_name.rbegin()[1] == '(' && link_name.rbegin()[0] == ')')
         {
-            if (auto result = do_lookup(get_entity_scope(context.value()) + link_name))
-                return result;
+            // ends with () even after processing
+            link_name.pop_back();
+            link_name.pop_back();
+        }
 
-            // go to parent
-            context = context.value().parent();
+        auto key = scopes.scope_ + link_name;
+        for (auto length : scopes.lengths_)
+        {
+            key.erase(length, key.size() - length - link_name.size());
+            if (auto result = do_lookup(length == 0u ? unscoped : key))
+                return to_result(result);
         }
 
         return type_safe::nullvar;
@@ -276,6 +482,7 @@ void register_documentation(const cppast::diagnostic_logger& logger, const linke
 {
     auto result = l.register_documentation(doc_e.link_name(), document,
                                            doc_e.get_documentation_id(), force_linking(doc_e));
+    l.register_entity(doc_e);
     if (!result)
         logger.log("standardese linker", make_diagnostic(cppast::source_location::make_entity(
                                                              doc_e.get_documentation_id().as_str()),
@@ -386,14 +593,20 @@ void standardese::resolve_links(const cppast::diagnostic_logger& logger, const l
         return markup::block_id();
     };
 
-    type_safe::optional_ref<const cppast::cpp_entity> context;
+    // the scopes only change with the context, not with every link,
+    // and the results of the lookups are remembered for the whole document
+    // and afterwards shared with the later documents
+    linker::scope_chain scopes(nullptr);
     markup::visit(document, [&](const markup::entity& entity) {
         if (entity.kind() == markup::entity_kind::documentation_link)
         {
             auto& link = static_cast<const markup::documentation_link&>(entity);
             if (auto unresolved = link.unresolved_destination())
             {
-                auto destination = l.lookup_documentation(context, unresolved.value());
+                // relative names depend on the context, not just on the entity
+                auto destination = link.target() && !is_relative(unresolved.value())
+                                       ? l.lookup_documentation(link.target().value())
+                                       : l.lookup_documentation(scopes, unresolved.value());
                 if (auto block = destination.optional_value(
                         type_safe::variant_type<markup::block_reference>{}))
                 {
@@ -415,6 +628,7 @@ void standardese::resolve_links(const cppast::diagnostic_logger& logger, const l
             }
         }
         else if (auto new_context = get_context(entity))
-            context = new_context;
+            scopes.set_context(new_context);
     });
+    l.merge_results(scopes);
 }
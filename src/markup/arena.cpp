@@ -0,0 +1,143 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include <standardese/markup/arena.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include <standardese/markup/entity.hpp>
+
+using namespace standardese::markup;
+
+namespace standardese
+{
+namespace markup
+{
+    namespace detail
+    {
+        // a monotonic buffer that is released once nothing refers to it anymore,
+        // allocations only happen on the thread of the scope, but entities can be destroyed
+        // anywhere
+        class arena
+        {
+        public:
+            arena() : refs_(1u), allocated_(0u), cur_(nullptr), end_(nullptr) {}
+
+            arena(const arena&) = delete;
+            arena& operator=(const arena&) = delete;
+
+            void* allocate(std::size_t size)
+            {
+                size = (size + alignof(std::max_align_t) - 1u) & ~(alignof(std::max_align_t) - 1u);
+                if (std::size_t(end_ - cur_) < size)
+                    grow(size);
+
+                auto result = cur_;
+                cur_ += size;
+                allocated_ += size;
+                refs_.fetch_add(1u, std::memory_order_relaxed);
+                return result;
+            }
+
+            void release() noexcept
+            {
+                if (refs_.fetch_sub(1u, std::memory_order_acq_rel) == 1u)
+                    delete this;
+            }
+
+            std::size_t allocated() const noexcept
+            {
+                return allocated_;
+            }
+
+        private:
+            static constexpr std::size_t min_block_size = 64u * 1024u;
+
+            void grow(std::size_t size)
+            {
+                auto block_size
+                    = std::max(size, blocks_.empty() ? min_block_size : 2u * block_size_);
+                blocks_.emplace_back(new max_align_block[block_size / sizeof(max_align_block) + 1u]);
+                block_size_ = block_size;
+
+                cur_ = reinterpret_cast<char*>(blocks_.back().get());
+                end_ = cur_ + block_size;
+            }
+
+            struct alignas(std::max_align_t) max_align_block
+            {
+                char data[alignof(std::max_align_t)];
+            };
+
+            std::atomic<std::size_t>                        refs_;
+            std::size_t                                     allocated_;
+            std::vector<std::unique_ptr<max_align_block[]>> blocks_;
+            std::size_t                                     block_size_ = 0u;
+            char*                                           cur_;
+            char*                                           end_;
+        };
+    } // namespace detail
+} // namespace markup
+} // namespace standardese
+
+namespace
+{
+thread_local detail::arena* current_arena = nullptr;
+
+// every entity starts with the arena it was allocated in, or null if it lives on the heap
+constexpr auto header_size = alignof(std::max_align_t);
+static_assert(header_size >= sizeof(detail::arena*), "header too small");
+} // namespace
+
+arena_scope::arena_scope() : arena_(new detail::arena), previous_(current_arena)
+{
+    current_arena = arena_;
+}
+
+arena_scope::~arena_scope() noexcept
+{
+    current_arena = previous_;
+    arena_->release();
+}
+
+std::size_t arena_scope::allocated() const noexcept
+{
+    return arena_->allocated();
+}
+
+heap_scope::heap_scope() noexcept : previous_(current_arena)
+{
+    current_arena = nullptr;
+}
+
+heap_scope::~heap_scope() noexcept
+{
+    current_arena = previous_;
+}
+
+void* entity::operator new(std::size_t size)
+{
+    auto arena  = current_arena;
+    auto memory = static_cast<char*>(arena ? arena->allocate(header_size + size)
+                                           : ::operator new(header_size + size));
+    *reinterpret_cast<detail::arena**>(memory) = arena;
+    return memory + header_size;
+}
+
+void entity::operator delete(void* memory) noexcept
+{
+    if (!memory)
+        return;
+
+    auto begin = static_cast<char*>(memory) - header_size;
+    if (auto arena = *reinterpret_cast<detail::arena**>(begin))
+        // the memory itself is only released with the arena
+        arena->release();
+    else
+        ::operator delete(begin);
+}
@@ -35,7 +35,12 @@ std::string block_id::as_output_str() const
 {
     std::string id;
     id.reserve(id_.size());
-    for (auto c : id_)
-        escape_char(id, c);
+    append_output_str(id);
     return id;
 }
+
+void block_id::append_output_str(std::string& str) const
+{
+    for (auto c : id_)
+        escape_char(str, c);
+}
@@ -4,6 +4,8 @@
 
 #include <standardese/markup/code_block.hpp>
 
+#include <cassert>
+
 #include <standardese/markup/entity_kind.hpp>
 
 using namespace standardese::markup;
@@ -48,14 +50,137 @@ entity_kind code_block::do_get_kind() const noexcept
     return entity_kind::code_block;
 }
 
+code_block::compact_builder& code_block::compact_builder::add_token(token_kind  kind,
+                                                                   const char* str,
+                                                                   std::size_t length)
+{
+    assert(kind != token_kind::link);
+    if (length == 0u)
+        return *this;
+
+    auto& result = *result_;
+    if (kind == token_kind::text && !result.tokens_.empty()
+        && result.tokens_.back().kind() == token_kind::text)
+        result.tokens_.back().length_ += std::uint32_t(length);
+    else
+        result.tokens_.push_back(token(kind, std::uint32_t(result.code_.size()),
+                                       std::uint32_t(length), 0u));
+    result.code_.append(str, length);
+    return *this;
+}
+
+code_block::compact_builder& code_block::compact_builder::add_indent(std::size_t level)
+{
+    if (level == 0u)
+        return *this;
+
+    auto& result = *result_;
+    if (!result.tokens_.empty() && result.tokens_.back().kind() == token_kind::text)
+        result.tokens_.back().length_ += std::uint32_t(level);
+    else
+        result.tokens_.push_back(
+            token(token_kind::text, std::uint32_t(result.code_.size()), std::uint32_t(level), 0u));
+    result.code_.append(level, ' ');
+    return *this;
+}
+
+code_block::compact_builder& code_block::compact_builder::add_link(
+    documentation_link::builder link, const char* identifier, std::size_t length)
+{
+    link.add_child(code_block::identifier::build(std::string(identifier, length)));
+    auto ptr = link.finish();
+    detail::parent_updater::set(*ptr, type_safe::ref(*result_));
+
+    auto& result = *result_;
+    result.tokens_.push_back(token(token_kind::link, std::uint32_t(result.code_.size()),
+                                   std::uint32_t(length), std::uint32_t(result.links_.size())));
+    result.code_.append(identifier, length);
+    result.link_ptrs_.push_back(ptr.get());
+    result.links_.push_back(std::move(ptr));
+    return *this;
+}
+
+namespace
+{
+std::unique_ptr<phrasing_entity> build_token(code_block::token_kind kind, std::string str)
+{
+    switch (kind)
+    {
+    case code_block::token_kind::text:
+        return text::build(std::move(str));
+    case code_block::token_kind::keyword:
+        return code_block::keyword::build(std::move(str));
+    case code_block::token_kind::identifier:
+        return code_block::identifier::build(std::move(str));
+    case code_block::token_kind::string_literal:
+        return code_block::string_literal::build(std::move(str));
+    case code_block::token_kind::int_literal:
+        return code_block::int_literal::build(std::move(str));
+    case code_block::token_kind::float_literal:
+        return code_block::float_literal::build(std::move(str));
+    case code_block::token_kind::punctuation:
+        return code_block::punctuation::build(std::move(str));
+    case code_block::token_kind::preprocessor:
+        return code_block::preprocessor::build(std::move(str));
+    case code_block::token_kind::soft_break:
+        return soft_break::build();
+
+    case code_block::token_kind::link:
+        break;
+    }
+
+    assert(false);
+    return nullptr;
+}
+} // namespace
+
+void code_block::materialize() const
+{
+    std::call_once(view_once_, [&] {
+        view_.reserve(tokens_.size());
+        for (auto& tok : tokens_)
+            if (tok.kind() == token_kind::link)
+                view_.push_back(std::move(links_[tok.link_]));
+            else
+            {
+                view_.push_back(
+                    build_token(tok.kind(), code_.substr(tok.offset(), tok.length())));
+                detail::parent_updater::set(*view_.back(), type_safe::ref(*this));
+            }
+        links_.clear();
+    });
+}
+
 void code_block::do_visit(detail::visitor_callback_t cb, void* mem) const
 {
-    for (auto& child : *this)
-        cb(mem, child);
+    if (compact_)
+        // only the links of a compact code block are entities on their own
+        for (auto link : link_ptrs_)
+            cb(mem, *link);
+    else
+        for (auto& child : *this)
+            cb(mem, child);
 }
 
 std::unique_ptr<entity> code_block::do_clone() const
 {
+    if (compact_)
+    {
+        compact_builder b(id(), language());
+        b.result_->code_      = code_;
+        b.result_->tokens_    = tokens_;
+        b.result_->link_ptrs_.reserve(link_ptrs_.size());
+        b.result_->links_.reserve(link_ptrs_.size());
+        for (auto link : link_ptrs_)
+        {
+            auto copy = detail::unchecked_downcast<documentation_link>(link->clone());
+            detail::parent_updater::set(*copy, type_safe::ref(*b.result_));
+            b.result_->link_ptrs_.push_back(copy.get());
+            b.result_->links_.push_back(std::move(copy));
+        }
+        return b.finish();
+    }
+
     builder b(id(), language());
     for (auto& child : *this)
         b.add_child(detail::unchecked_downcast<phrasing_entity>(child.clone()));
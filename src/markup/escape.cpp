@@ -0,0 +1,299 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "escape.hpp"
+
+#include <cstdint>
+
+#if defined(__AVX2__)
+#    include <immintrin.h>
+#    define STANDARDESE_DETAIL_ESCAPE_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    include <emmintrin.h>
+#    define STANDARDESE_DETAIL_ESCAPE_SSE2 1
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#    include <intrin.h>
+#endif
+
+using namespace standardese::markup;
+
+namespace
+{
+enum class url_rule : unsigned char
+{
+    copy,
+    percent_encode,
+    ampersand,
+    apostrophe,
+};
+
+// the escape rules of every character
+struct escape_tables
+{
+    const char* html[256];
+    url_rule    url[256];
+
+    escape_tables() noexcept
+    {
+        for (auto i = 0u; i != 256u; ++i)
+        {
+            html[i] = nullptr;
+            url[i]  = url_rule::percent_encode;
+        }
+
+        html[unsigned('&')]  = "&amp;";
+        html[unsigned('<')]  = "&lt;";
+        html[unsigned('>')]  = "&gt;";
+        html[unsigned('"')]  = "&quot;";
+        html[unsigned('\'')] = "&#x27;";
+        html[unsigned('/')]  = "&#x2F;";
+
+        // don't escape reserved URL characters
+        // don't escape safe URL characters
+        for (auto ptr = "-_.+!*(),%#@?=;:/,+$"; *ptr; ++ptr)
+            url[unsigned(*ptr)] = url_rule::copy;
+        for (auto c = '0'; c <= '9'; ++c)
+            url[unsigned(c)] = url_rule::copy;
+        for (auto c = 'a'; c <= 'z'; ++c)
+            url[unsigned(c)] = url_rule::copy;
+        for (auto c = 'A'; c <= 'Z'; ++c)
+            url[unsigned(c)] = url_rule::copy;
+        url[unsigned('&')]  = url_rule::ampersand;
+        url[unsigned('\'')] = url_rule::apostrophe;
+    }
+};
+
+const escape_tables tables;
+
+bool needs_html_escaping(char c) noexcept
+{
+    return tables.html[static_cast<unsigned char>(c)] != nullptr;
+}
+
+bool needs_url_escaping(char c) noexcept
+{
+    return tables.url[static_cast<unsigned char>(c)] != url_rule::copy;
+}
+
+template <typename Predicate>
+const char* find_scalar(const char* ptr, const char* end, Predicate needs_escaping) noexcept
+{
+    while (ptr != end && !needs_escaping(*ptr))
+        ++ptr;
+    return ptr;
+}
+
+#if defined(STANDARDESE_DETAIL_ESCAPE_AVX2) || defined(STANDARDESE_DETAIL_ESCAPE_SSE2)
+unsigned count_trailing_zeros(std::uint32_t mask) noexcept
+{
+#    if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return unsigned(index);
+#    else
+    return unsigned(__builtin_ctz(mask));
+#    endif
+}
+#endif
+
+#if defined(STANDARDESE_DETAIL_ESCAPE_AVX2)
+struct simd
+{
+    using reg = __m256i;
+
+    static constexpr std::size_t   size     = 32u;
+    static constexpr std::uint32_t all_mask = 0xFFFFFFFFu;
+
+    static reg load(const char* ptr) noexcept
+    {
+        return _mm256_loadu_si256(reinterpret_cast<const reg*>(ptr));
+    }
+
+    static reg eq(reg v, char c) noexcept
+    {
+        return _mm256_cmpeq_epi8(v, _mm256_set1_epi8(c));
+    }
+
+    // lo <= v <= hi, as unsigned characters
+    static reg in_range(reg v, char lo, char hi) noexcept
+    {
+        auto offset = _mm256_sub_epi8(v, _mm256_set1_epi8(lo));
+        return _mm256_cmpeq_epi8(_mm256_min_epu8(offset, _mm256_set1_epi8(char(hi - lo))),
+                                 offset);
+    }
+
+    static reg either(reg a, reg b) noexcept
+    {
+        return _mm256_or_si256(a, b);
+    }
+
+    static std::uint32_t mask(reg v) noexcept
+    {
+        return std::uint32_t(_mm256_movemask_epi8(v));
+    }
+};
+#elif defined(STANDARDESE_DETAIL_ESCAPE_SSE2)
+struct simd
+{
+    using reg = __m128i;
+
+    static constexpr std::size_t   size     = 16u;
+    static constexpr std::uint32_t all_mask = 0xFFFFu;
+
+    static reg load(const char* ptr) noexcept
+    {
+        return _mm_loadu_si128(reinterpret_cast<const reg*>(ptr));
+    }
+
+    static reg eq(reg v, char c) noexcept
+    {
+        return _mm_cmpeq_epi8(v, _mm_set1_epi8(c));
+    }
+
+    // lo <= v <= hi, as unsigned characters
+    static reg in_range(reg v, char lo, char hi) noexcept
+    {
+        auto offset = _mm_sub_epi8(v, _mm_set1_epi8(lo));
+        return _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8(char(hi - lo))), offset);
+    }
+
+    static reg either(reg a, reg b) noexcept
+    {
+        return _mm_or_si128(a, b);
+    }
+
+    static std::uint32_t mask(reg v) noexcept
+    {
+        return std::uint32_t(_mm_movemask_epi8(v));
+    }
+};
+#endif
+
+// returns the first character that needs HTML escaping, or end
+const char* find_html_special(const char* ptr, const char* end) noexcept
+{
+#if defined(STANDARDESE_DETAIL_ESCAPE_AVX2) || defined(STANDARDESE_DETAIL_ESCAPE_SSE2)
+    for (; std::size_t(end - ptr) >= simd::size; ptr += simd::size)
+    {
+        auto v       = simd::load(ptr);
+        auto special = simd::either(simd::either(simd::either(simd::eq(v, '&'), simd::eq(v, '<')),
+                                                 simd::either(simd::eq(v, '>'), simd::eq(v, '"'))),
+                                    simd::either(simd::eq(v, '\''), simd::eq(v, '/')));
+        if (auto mask = simd::mask(special))
+            return ptr + count_trailing_zeros(mask);
+    }
+#endif
+    return find_scalar(ptr, end, needs_html_escaping);
+}
+
+// returns the first character that needs URL escaping, or end
+const char* find_url_special(const char* ptr, const char* end) noexcept
+{
+#if defined(STANDARDESE_DETAIL_ESCAPE_AVX2) || defined(STANDARDESE_DETAIL_ESCAPE_SSE2)
+    for (; std::size_t(end - ptr) >= simd::size; ptr += simd::size)
+    {
+        // same characters as url_rule::copy
+        auto v    = simd::load(ptr);
+        auto safe = simd::either(simd::either(simd::either(simd::eq(v, '!'),
+                                                           simd::in_range(v, '#', '%')),
+                                              simd::either(simd::in_range(v, '(', ';'),
+                                                           simd::eq(v, '='))),
+                                 simd::either(simd::either(simd::in_range(v, '?', 'Z'),
+                                                           simd::eq(v, '_')),
+                                              simd::in_range(v, 'a', 'z')));
+        if (auto mask = ~simd::mask(safe) & simd::all_mask)
+            return ptr + count_trailing_zeros(mask);
+    }
+#endif
+    return find_scalar(ptr, end, needs_url_escaping);
+}
+
+void append_html_escaped(std::string& out, char c)
+{
+    out += tables.html[static_cast<unsigned char>(c)];
+}
+
+void append_url_escaped(std::string& out, char c)
+{
+    static constexpr char hex_digits[] = "0123456789ABCDEF";
+
+    auto byte = static_cast<unsigned char>(c);
+    switch (tables.url[byte])
+    {
+    case url_rule::copy:
+        out += c;
+        break;
+    case url_rule::percent_encode:
+        out += '%';
+        out += hex_digits[byte >> 4];
+        out += hex_digits[byte & 0xF];
+        break;
+    case url_rule::ampersand:
+        out += "&amp;";
+        break;
+    case url_rule::apostrophe:
+        out += "&#x27";
+        break;
+    }
+}
+
+// copies the runs between the special characters in bulk
+template <typename Find, typename Escape>
+void write_escaped(std::string& out, const char* str, std::size_t length, Find find_special,
+                   Escape escape)
+{
+    auto end = str + length;
+    while (true)
+    {
+        auto special = find_special(str, end);
+        out.append(str, special);
+        if (special == end)
+            break;
+
+        escape(out, *special);
+        str = special + 1;
+    }
+}
+} // namespace
+
+void detail::write_html_text(std::string& out, const char* str, std::size_t length)
+{
+    write_escaped(out, str, length, find_html_special, append_html_escaped);
+}
+
+void detail::write_html_url(std::string& out, const char* url, std::size_t length)
+{
+    write_escaped(out, url, length, find_url_special, append_url_escaped);
+}
+
+void detail::write_html_text_scalar(std::string& out, const char* str, std::size_t length)
+{
+    write_escaped(out, str, length,
+                  [](const char* ptr, const char* end) {
+                      return find_scalar(ptr, end, needs_html_escaping);
+                  },
+                  append_html_escaped);
+}
+
+void detail::write_html_url_scalar(std::string& out, const char* url, std::size_t length)
+{
+    write_escaped(out, url, length,
+                  [](const char* ptr, const char* end) {
+                      return find_scalar(ptr, end, needs_url_escaping);
+                  },
+                  append_url_escaped);
+}
+
+const char* detail::escape_instruction_set() noexcept
+{
+#if defined(STANDARDESE_DETAIL_ESCAPE_AVX2)
+    return "avx2";
+#elif defined(STANDARDESE_DETAIL_ESCAPE_SSE2)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
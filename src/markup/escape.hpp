@@ -5,9 +5,8 @@
 #ifndef STANDARDESE_MARKUP_ESCAPE_HPP_INCLUDED
 #define STANDARDESE_MARKUP_ESCAPE_HPP_INCLUDED
 
-#include <cstdio>
 #include <cstring>
-#include <ostream>
+#include <string>
 
 namespace standardese
 {
@@ -15,61 +14,30 @@ namespace markup
 {
     namespace detail
     {
-        inline void write_html_text(std::ostream& out, const char* str)
-        {
-            // implements rule 1 here:
-            // https://www.owasp.org/index.php/XSS_(Cross_Site_Scripting)_Prevention_Cheat_Sheet
-            for (auto ptr = str; *ptr; ++ptr)
-            {
-                auto c = *ptr;
-                if (c == '&')
-                    out << "&amp;";
-                else if (c == '<')
-                    out << "&lt;";
-                else if (c == '>')
-                    out << "&gt;";
-                else if (c == '"')
-                    out << "&quot;";
-                else if (c == '\'')
-                    out << "&#x27;";
-                else if (c == '/')
-                    out << "&#x2F;";
-                else
-                    out << c;
-            }
-        }
+        // appends the text with the HTML special characters escaped,
+        // implements rule 1 here:
+        // https://www.owasp.org/index.php/XSS_(Cross_Site_Scripting)_Prevention_Cheat_Sheet
+        void write_html_text(std::string& out, const char* str, std::size_t length);
 
-        inline bool needs_url_escaping(char c)
+        inline void write_html_text(std::string& out, const char* str)
         {
-            // don't escape reserved URL characters
-            // don't escape safe URL characters
-            char safe[] = "-_.+!*(),%#@?=;:/,+$"
-                          "0123456789"
-                          "abcdefghijklmnopqrstuvwxyz"
-                          "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
-            return std::strchr(safe, c) == nullptr;
+            write_html_text(out, str, std::strlen(str));
         }
 
-        inline void write_html_url(std::ostream& out, const char* url)
+        // appends the URL with all characters that are neither reserved nor safe escaped
+        void write_html_url(std::string& out, const char* url, std::size_t length);
+
+        inline void write_html_url(std::string& out, const char* url)
         {
-            for (auto ptr = url; *ptr; ++ptr)
-            {
-                auto c = *ptr;
-                if (c == '&')
-                    out << "&amp;";
-                else if (c == '\'')
-                    out << "&#x27";
-                else if (needs_url_escaping(c))
-                {
-                    char buf[3];
-                    std::snprintf(buf, 3, "%02X", unsigned(c));
-                    out << "%";
-                    out << buf;
-                }
-                else
-                    out << c;
-            }
+            write_html_url(out, url, std::strlen(url));
         }
+
+        // the same as the functions above, but without SIMD
+        void write_html_text_scalar(std::string& out, const char* str, std::size_t length);
+        void write_html_url_scalar(std::string& out, const char* url, std::size_t length);
+
+        // the instruction set used by the functions above, "avx2", "sse2" or "scalar"
+        const char* escape_instruction_set() noexcept;
     } // namespace detail
 } // namespace markup
 } // namespace standardese
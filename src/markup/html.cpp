@@ -9,7 +9,6 @@
 
 #include <type_safe/deferred_construction.hpp>
 #include <type_safe/flag.hpp>
-#include <type_safe/reference.hpp>
 
 #include <standardese/markup/block.hpp>
 #include <standardese/markup/code_block.hpp>
@@ -33,20 +32,69 @@ using namespace standardese::markup;
 
 namespace
 {
+// the output of a single generator call
+// everything is written into a buffer that is passed to the stream in big chunks
+class html_output
+{
+public:
+    explicit html_output(std::ostream& out, const std::string& prefix,
+                         const std::string& extension)
+    : out_(out), prefix_(prefix), ext_(extension)
+    {
+        buffer_.reserve(flush_size + flush_size / 4u);
+    }
+
+    html_output(const html_output&) = delete;
+    html_output& operator=(const html_output&) = delete;
+
+    std::string& buffer() noexcept
+    {
+        return buffer_;
+    }
+
+    const std::string& prefix() const noexcept
+    {
+        return prefix_;
+    }
+
+    const std::string& extension() const noexcept
+    {
+        return ext_;
+    }
+
+    void flush_if_full()
+    {
+        if (buffer_.size() >= flush_size)
+            flush();
+    }
+
+    void flush()
+    {
+        out_.write(buffer_.data(), std::streamsize(buffer_.size()));
+        buffer_.clear();
+    }
+
+private:
+    static constexpr std::size_t flush_size = 64u * 1024u;
+
+    std::string        buffer_;
+    std::ostream&      out_;
+    const std::string& prefix_;
+    const std::string& ext_;
+};
+
 class html_stream
 {
 public:
-    explicit html_stream(type_safe::object_ref<std::ostream> out, std::string prefix,
-                         std::string extension)
-    : out_(out), prefix_(std::move(prefix)), ext_(std::move(extension)), top_level_(true),
-      closing_newl_(false)
+    explicit html_stream(html_output& output)
+    : output_(&output), closing_(nullptr), top_level_(true), closing_newl_(false)
     {}
 
     html_stream(html_stream&& other)
-    : closing_(std::move(other.closing_)), out_(other.out_), prefix_(std::move(other.prefix_)),
-      ext_(other.extension()), top_level_(other.top_level_), closing_newl_(other.closing_newl_)
+    : output_(other.output_), closing_(other.closing_), top_level_(other.top_level_),
+      closing_newl_(other.closing_newl_)
     {
-        other.closing_.clear();
+        other.closing_ = nullptr;
         other.top_level_.reset();
         other.closing_newl_.reset();
     }
@@ -60,7 +108,7 @@ public:
 
     const std::string& extension() const noexcept
     {
-        return ext_;
+        return output_->extension();
     }
 
     // opens a new tag
@@ -71,91 +119,133 @@ public:
     }
 
     // opens tag with id and classes
-    html_stream open_tag(bool open_newl, bool closing_newl, const char* tag, block_id id,
+    // tag must be a string literal, as it is used for the closing tag
+    html_stream open_tag(bool open_newl, bool closing_newl, const char* tag, const block_id& id,
                          const char* classes = "")
     {
-        *out_ << "<" << tag;
+        auto& buffer = output_->buffer();
+        buffer += '<';
+        buffer += tag;
         if (!id.empty())
         {
-            *out_ << " id=\"standardese-";
-            write(id.as_output_str().c_str());
-            *out_ << '"';
+            // the output id doesn't need HTML escaping
+            buffer += " id=\"standardese-";
+            id.append_output_str(buffer);
+            buffer += '"';
         }
         if (*classes)
         {
-            *out_ << " class=\"standardese-";
-            write(classes);
-            *out_ << '"';
+            buffer += " class=\"standardese-";
+            detail::write_html_text(buffer, classes);
+            buffer += '"';
         }
-        *out_ << ">";
+        buffer += '>';
 
         if (open_newl)
-            *out_ << "\n";
+            buffer += '\n';
 
-        return html_stream(out_, prefix_, extension(), tag, closing_newl);
+        return html_stream(*output_, tag, closing_newl);
     }
 
     html_stream open_link(const char* title, const char* url, bool prefix)
     {
-        *out_ << "<a href=\"";
+        auto& buffer = output_->buffer();
+        buffer += "<a href=\"";
         if (prefix)
-            detail::write_html_url(*out_, prefix_.c_str());
-        detail::write_html_url(*out_, url);
-        *out_ << '"';
-        if (*title)
+            detail::write_html_url(buffer, output_->prefix().c_str());
+        detail::write_html_url(buffer, url);
+        buffer += '"';
+        return finish_link(title);
+    }
+
+    // opens a link to the given internal destination
+    html_stream open_link(const char* title, const block_reference& dest)
+    {
+        auto& buffer = output_->buffer();
+        buffer += "<a href=\"";
+        detail::write_html_url(buffer, output_->prefix().c_str());
+        if (dest.document())
         {
-            *out_ << " title=\"";
-            write(title);
-            *out_ << '"';
+            auto& document = dest.document().value();
+            detail::write_html_url(buffer, document.name().c_str());
+            if (document.needs_extension())
+            {
+                buffer += '.';
+                detail::write_html_url(buffer, extension().c_str());
+            }
         }
-        *out_ << ">";
-        return html_stream(out_, prefix_, extension(), "a", false);
+        // the output id doesn't need URL escaping
+        buffer += "#standardese-";
+        dest.id().append_output_str(buffer);
+        buffer += '"';
+        return finish_link(title);
     }
 
     // closes the current tag
     void close()
     {
-        if (!closing_.empty())
-            *out_ << "</" << closing_ << ">";
-        closing_.clear();
+        auto& buffer = output_->buffer();
+        if (closing_)
+        {
+            buffer += "</";
+            buffer += closing_;
+            buffer += '>';
+        }
+        closing_ = nullptr;
         if (closing_newl_.try_reset())
-            *out_ << '\n';
+            buffer += '\n';
+        output_->flush_if_full();
     }
 
     void write_newl()
     {
         if (!top_level_.try_reset())
-            *out_ << '\n';
+            output_->buffer() += '\n';
     }
 
     // writes HTML text, properly escaped
     void write(const char* str)
     {
-        detail::write_html_text(*out_, str);
+        detail::write_html_text(output_->buffer(), str);
     }
 
     void write(const std::string& str)
     {
-        write(str.c_str());
+        detail::write_html_text(output_->buffer(), str.c_str(), str.size());
+    }
+
+    void write(const char* str, std::size_t length)
+    {
+        detail::write_html_text(output_->buffer(), str, length);
     }
 
     // writes raw HTML code
     void write_html(const char* html)
     {
-        *out_ << html;
+        output_->buffer() += html;
     }
 
 private:
-    explicit html_stream(type_safe::object_ref<std::ostream> out, std::string prefix,
-                         std::string extension, std::string closing, bool closing_newl)
-    : closing_(std::move(closing)), out_(out), prefix_(std::move(prefix)),
-      ext_(std::move(extension)), top_level_(false), closing_newl_(closing_newl)
+    explicit html_stream(html_output& output, const char* closing, bool closing_newl)
+    : output_(&output), closing_(closing), top_level_(false), closing_newl_(closing_newl)
     {}
 
-    std::string                         closing_;
-    type_safe::object_ref<std::ostream> out_;
-    std::string                         prefix_, ext_;
-    type_safe::flag                     top_level_, closing_newl_;
+    html_stream finish_link(const char* title)
+    {
+        auto& buffer = output_->buffer();
+        if (*title)
+        {
+            buffer += " title=\"";
+            detail::write_html_text(buffer, title);
+            buffer += '"';
+        }
+        buffer += '>';
+        return html_stream(*output_, "a", false);
+    }
+
+    html_output*    output_;
+    const char*     closing_;
+    type_safe::flag top_level_, closing_newl_;
 };
 
 void write_entity(html_stream& s, const entity& e);
@@ -203,6 +293,7 @@ void write(html_stream& s, const template_document& doc)
 }
 
 void write(html_stream& s, const code_block& cb, bool is_synopsis = false);
+void write(html_stream& s, const documentation_link& link);
 void write_list_item(html_stream& s, const list_item_base& item);
 
 // write synopsis and sections
@@ -499,6 +590,50 @@ void write(html_stream& s, const block_quote& quote)
     write_children(bq, quote);
 }
 
+const char* get_token_class(code_block::token_kind kind) noexcept
+{
+    switch (kind)
+    {
+    case code_block::token_kind::keyword:
+        return "kwd";
+    case code_block::token_kind::identifier:
+        return "typ dec var fun";
+    case code_block::token_kind::string_literal:
+        return "str";
+    case code_block::token_kind::int_literal:
+    case code_block::token_kind::float_literal:
+        return "lit";
+    case code_block::token_kind::punctuation:
+        return "pun";
+    case code_block::token_kind::preprocessor:
+        return "pre";
+
+    case code_block::token_kind::text:
+    case code_block::token_kind::soft_break:
+    case code_block::token_kind::link:
+        break;
+    }
+
+    return nullptr;
+}
+
+void write_tokens(html_stream& s, const code_block& cb)
+{
+    for (auto& tok : cb.tokens())
+        if (tok.kind() == code_block::token_kind::link)
+            write(s, cb.link(tok));
+        else if (auto classes = get_token_class(tok.kind()))
+        {
+            s.write_html(R"(<span class=")");
+            s.write_html(classes);
+            s.write_html(R"(">)");
+            s.write(cb.code().data() + tok.offset(), tok.length());
+            s.write_html("</span>");
+        }
+        else
+            s.write(cb.code().data() + tok.offset(), tok.length());
+}
+
 void write(html_stream& s, const code_block& cb, bool is_synopsis)
 {
     std::string classes;
@@ -509,7 +644,10 @@ void write(html_stream& s, const code_block& cb, bool is_synopsis)
 
     auto pre  = s.open_tag(false, true, "pre", block_id());
     auto code = pre.open_tag(false, false, "code", cb.id(), classes.c_str());
-    write_children(code, cb);
+    if (cb.is_compact())
+        write_tokens(code, cb);
+    else
+        write_children(code, cb);
 }
 
 void write(html_stream& s, const code_block::keyword& text)
@@ -615,14 +753,7 @@ void write(html_stream& s, const documentation_link& link)
 {
     if (link.internal_destination())
     {
-        auto url = link.internal_destination()
-                       .value()
-                       .document()
-                       .map(&output_name::file_name, s.extension().c_str())
-                       .value_or("");
-        url += "#standardese-" + link.internal_destination().value().id().as_output_str();
-
-        auto a = s.open_link(link.title().c_str(), url.c_str(), true);
+        auto a = s.open_link(link.title().c_str(), link.internal_destination().value());
         write_children(a, link);
     }
     else if (link.external_destination())
@@ -716,7 +847,11 @@ generator standardese::markup::html_generator(const std::string& prefix,
                                               const std::string& extension) noexcept
 {
     return [prefix, extension](std::ostream& out, const entity& e) {
-        html_stream s(type_safe::ref(out), prefix, extension);
-        write_entity(s, e);
+        html_output output(out, prefix, extension);
+        {
+            html_stream s(output);
+            write_entity(s, e);
+        }
+        output.flush();
     };
 }
@@ -35,6 +35,7 @@ entity_kind documentation_link::do_get_kind() const noexcept
 std::unique_ptr<entity> documentation_link::do_clone() const
 {
     builder b(title(), type_safe::copy(unresolved_destination()).value_or(""));
+    b.peek().target_ = target_;
 
     if (internal_destination())
         b.peek().resolve_destination(internal_destination().value());
@@ -4,10 +4,12 @@
 
 #include <standardese/markup/generator.hpp>
 
+#include <algorithm>
 #include <cassert>
-#include <cmark-gfm.h>
+#include <cstdio>
+#include <cstring>
 #include <ostream>
-#include <sstream>
+#include <vector>
 
 #include <standardese/markup/block.hpp>
 #include <standardese/markup/code_block.hpp>
@@ -37,95 +39,822 @@ struct options
     bool        use_html;
 };
 
-void build_entity(cmark_node* parent, const options& opt, const entity& e);
+// the nodes of a CommonMark document
+enum class node_type
+{
+    document,
+    block_quote,
+    list,
+    item,
+    code_block,
+    html_block,
+    paragraph,
+    heading,
+    thematic_break,
+
+    text,
+    soft_break,
+    line_break,
+    code,
+    html_inline,
+    emph,
+    strong,
+    link,
+};
 
-template <typename T>
-void handle_children(cmark_node* node, const options& opt, const T& container)
+bool is_block(node_type type) noexcept
 {
-    for (auto& child : container)
-        build_entity(node, opt, child);
+    return type <= node_type::thematic_break;
 }
 
-cmark_node* build_emph(const char* str)
+// whether a node can be a child of the other one, nodes that can't are dropped
+bool can_contain(node_type parent, node_type child) noexcept
 {
-    auto emph = cmark_node_new(CMARK_NODE_EMPH);
-    auto text = cmark_node_new(CMARK_NODE_TEXT);
-    cmark_node_set_literal(text, str);
-    cmark_node_append_child(emph, text);
-    return emph;
+    switch (parent)
+    {
+    case node_type::document:
+    case node_type::block_quote:
+    case node_type::item:
+        return is_block(child) && child != node_type::item;
+    case node_type::list:
+        return child == node_type::item;
+    case node_type::paragraph:
+    case node_type::heading:
+    case node_type::emph:
+    case node_type::strong:
+    case node_type::link:
+        return !is_block(child);
+
+    case node_type::code_block:
+    case node_type::html_block:
+    case node_type::thematic_break:
+    case node_type::text:
+    case node_type::soft_break:
+    case node_type::line_break:
+    case node_type::code:
+    case node_type::html_inline:
+        break;
+    }
+
+    return false;
 }
 
-cmark_node* build_heading(unsigned level, const char* str)
+enum class escaping
 {
-    auto heading = cmark_node_new(CMARK_NODE_HEADING);
-    cmark_node_set_heading_level(heading, int(level));
+    literal,
+    normal,
+    url,
+    title,
+};
 
-    if (str)
-    {
-        auto text = cmark_node_new(CMARK_NODE_TEXT);
-        cmark_node_set_literal(text, str);
-        cmark_node_append_child(heading, text);
-    }
+bool is_space(char c) noexcept
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
 
-    return heading;
+bool is_digit(char c) noexcept
+{
+    return c >= '0' && c <= '9';
 }
 
-void build(cmark_node* parent, const options& opt, const code_block& cb);
+bool is_alpha(char c) noexcept
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
 
-void build_list_item(cmark_node* list, const options& opt, const list_item_base& item);
+// the characters that can't be copied as part of a run,
+// either because they might need escaping or because they start a new line
+struct special_tables
+{
+    bool table[4][256];
 
-void build_documentation(cmark_node* parent, const options& opt, const documentation_entity& doc)
+    special_tables() noexcept
+    {
+        for (auto& t : table)
+        {
+            std::fill(std::begin(t), std::end(t), false);
+            t[unsigned('\n')] = true;
+        }
+
+        auto set = [&](escaping e, const char* chars) {
+            for (; *chars; ++chars)
+                table[int(e)][unsigned(*chars)] = true;
+        };
+        set(escaping::normal, "*_[]#<>\\`~!&-+=.)");
+        set(escaping::url, "`<>\\() \t\v\f\r");
+        set(escaping::title, "`<>\"\\");
+    }
+};
+
+const special_tables specials;
+
+// writes CommonMark or plain text directly while the markup is traversed
+//
+// The output is the same as the one of the cmark renderers with CMARK_OPT_NOBREAKS
+// for the equivalent cmark document, without building it.
+// The structure is tracked by opening and closing nodes like the events of a cmark iterator,
+// nodes that can't be added to the current one are rejected.
+// Inline code and code blocks collect their literal until they are closed.
+class markdown_writer
 {
-    if (opt.use_html)
+public:
+    enum flavor
     {
-        auto html = cmark_node_new(CMARK_NODE_HTML_BLOCK);
+        commonmark,
+        plaintext,
+    };
 
-        std::ostringstream stream;
-        stream << "<span id=\"standardese-";
-        detail::write_html_text(stream, doc.id().as_output_str().c_str());
-        stream << "\"></span>\n";
+    explicit markdown_writer(std::ostream& out, const options& opt, flavor f, node_type root)
+    : out_(out), opt_(opt), flavor_(f), need_cr_(0u), newlines_(2u), last_('\0'),
+      begin_line_(true), begin_content_(true), in_tight_(false)
+    {
+        buffer_.reserve(flush_size + flush_size / 4u);
+        frames_.push_back(frame(root, false));
+    }
 
-        cmark_node_set_literal(html, stream.str().c_str());
-        cmark_node_append_child(parent, html);
+    markdown_writer(const markdown_writer&) = delete;
+    markdown_writer& operator=(const markdown_writer&) = delete;
+
+    const options& opt() const noexcept
+    {
+        return opt_;
     }
 
-    if (doc.synopsis())
-        build(parent, opt, doc.synopsis().value());
+    flavor output_flavor() const noexcept
+    {
+        return flavor_;
+    }
 
-    if (auto brief = doc.brief_section())
+    // the type of the innermost open node
+    node_type parent_type() const noexcept
     {
-        auto paragraph = cmark_node_new(CMARK_NODE_PARAGRAPH);
-        handle_children(paragraph, opt, brief.value());
-        cmark_node_append_child(parent, paragraph);
+        return frames_.back().type;
     }
 
-    // write inline sections
+    //=== container nodes ===//
+    // they return whether the node could be opened,
+    // if so it has to be closed again
+    bool open(node_type type)
     {
-        for (auto& section : doc.doc_sections())
-            if (section.kind() != entity_kind::inline_section)
-                continue;
-            else
+        assert(type == node_type::block_quote || type == node_type::paragraph
+               || type == node_type::strong || type == node_type::link);
+        if (!push(type))
+            return false;
+
+        if (flavor_ == plaintext)
+            return true;
+        else if (type == node_type::block_quote)
+        {
+            write_literal("> ");
+            begin_content_ = true;
+            prefix_ += "> ";
+        }
+        else if (type == node_type::strong)
+            write_literal("**");
+        else if (type == node_type::link)
+            write_literal("[");
+        return true;
+    }
+
+    bool open_heading(unsigned level)
+    {
+        if (!push(node_type::heading))
+            return false;
+
+        if (flavor_ == commonmark)
+            write_literal(std::string(level, '#').append(1u, ' ').c_str());
+        begin_content_ = true;
+        return true;
+    }
+
+    bool open_list(bool ordered, bool tight)
+    {
+        if (!push(node_type::list))
+            return false;
+        frames_.back().ordered = ordered;
+        frames_.back().tight   = tight;
+        return true;
+    }
+
+    bool open_item()
+    {
+        if (parent_type() != node_type::list)
+            return false;
+
+        auto& list  = frames_.back();
+        auto  first = list.number == 0u;
+
+        char marker[16];
+        if (list.ordered)
+        {
+            auto number = list.number + 1u;
+            std::snprintf(marker, sizeof(marker), "%u.%s", number, number < 10u ? "  " : " ");
+        }
+        else
+            std::strcpy(marker, "  - ");
+        ++list.number;
+
+        // the first item doesn't change the tight state yet,
+        // so the blank line before the list is kept
+        if (!push(node_type::item, !first))
+            return false;
+        frames_.back().number = unsigned(std::strlen(marker));
+
+        write_literal(marker);
+        begin_content_ = true;
+        prefix_.append(frames_.back().number, ' ');
+        return true;
+    }
+
+    bool open_emph(bool only_child)
+    {
+        // *x* inside of *...* would be strong emphasis
+        auto nested = only_child && parent_type() == node_type::emph;
+        if (!push(node_type::emph))
+            return false;
+        frames_.back().delim = nested ? "_" : "*";
+
+        if (flavor_ == commonmark)
+            write_literal(frames_.back().delim);
+        return true;
+    }
+
+    bool open_code()
+    {
+        if (!push(node_type::code))
+            return false;
+        literal_.clear();
+        return true;
+    }
+
+    // info must stay valid until the block is closed
+    bool open_code_block(const char* info)
+    {
+        if (!push(node_type::code_block))
+            return false;
+        frames_.back().delim = info;
+        literal_.clear();
+        return true;
+    }
+
+    // closes any node except a link
+    void close()
+    {
+        auto& cur = frames_.back();
+        assert(cur.type != node_type::link);
+        if (cur.type == node_type::code)
+            write_code(literal_);
+        else if (cur.type == node_type::code_block)
+            write_code_block(cur.delim, literal_, cur.first_in_item);
+        else
+        {
+            in_tight_ = cur.in_tight;
+            switch (cur.type)
             {
-                auto& sec = static_cast<const inline_section&>(section);
+            case node_type::block_quote:
+                // the plain text renderer ignores block quotes entirely
+                if (flavor_ == commonmark)
+                {
+                    prefix_.resize(prefix_.size() - 2u);
+                    blankline();
+                }
+                break;
+            case node_type::list:
+                // decided once the next sibling is known
+                frames_[frames_.size() - 2u].after_list = true;
+                break;
+            case node_type::item:
+                prefix_.resize(prefix_.size() - cur.number);
+                cr();
+                break;
+            case node_type::paragraph:
+            case node_type::heading:
+                blankline();
+                break;
+            case node_type::emph:
+            case node_type::strong:
+                if (flavor_ == commonmark)
+                    write_literal(cur.type == node_type::emph ? cur.delim : "**");
+                break;
+
+            default:
+                break;
+            }
+        }
+
+        frames_.pop_back();
+        flush_if_full();
+    }
 
-                auto paragraph = cmark_node_new(CMARK_NODE_PARAGRAPH);
-                cmark_node_append_child(parent, paragraph);
+    void close_link(const std::string& url, const std::string& title)
+    {
+        assert(parent_type() == node_type::link);
+        in_tight_ = frames_.back().in_tight;
+        if (flavor_ == commonmark)
+        {
+            write_literal("](");
+            write(url.c_str(), url.size(), escaping::url);
+            if (!title.empty())
+            {
+                write_literal(" \"");
+                write(title.c_str(), title.size(), escaping::title);
+                write_literal("\"");
+            }
+            write_literal(")");
+        }
 
-                // add section name
-                auto emph = build_emph((sec.name() + ":").c_str());
-                cmark_node_append_child(paragraph, emph);
-                auto sep = cmark_node_new(CMARK_NODE_TEXT);
-                cmark_node_set_literal(sep, " ");
-                cmark_node_append_child(paragraph, sep);
+        frames_.pop_back();
+        flush_if_full();
+    }
+
+    //=== leaf nodes ===//
+    void text(const char* str, std::size_t length)
+    {
+        if (leaf(node_type::text))
+            write(str, length, escaping::normal);
+    }
+
+    void text(const std::string& str)
+    {
+        text(str.c_str(), str.size());
+    }
+
+    void soft_break()
+    {
+        if (leaf(node_type::soft_break))
+            write_literal(" ");
+    }
 
-                // build section content
-                handle_children(paragraph, opt, sec);
+    void line_break()
+    {
+        if (leaf(node_type::line_break))
+        {
+            if (flavor_ == commonmark)
+                write_literal("  ");
+            cr();
+        }
+    }
+
+    void html_inline(const std::string& html)
+    {
+        if (leaf(node_type::html_inline) && flavor_ == commonmark)
+            write(html.c_str(), html.size(), escaping::literal);
+    }
+
+    void html_block(const std::string& html)
+    {
+        if (leaf(node_type::html_block) && flavor_ == commonmark)
+        {
+            blankline();
+            write(html.c_str(), html.size(), escaping::literal);
+            blankline();
+        }
+    }
+
+    void thematic_break()
+    {
+        if (leaf(node_type::thematic_break))
+        {
+            blankline();
+            if (flavor_ == commonmark)
+            {
+                write_literal("-----");
+                blankline();
             }
+        }
+    }
+
+    // a link whose content is its URL, only in CommonMark
+    void autolink(const std::string& url)
+    {
+        assert(flavor_ == commonmark);
+        if (leaf(node_type::link))
+        {
+            // e-mail addresses are autolinks on their own
+            auto skip = url.compare(0u, 7u, "mailto:") == 0 ? 7u : 0u;
+            write_literal("<");
+            write(url.c_str() + skip, url.size() - skip, escaping::literal);
+            write_literal(">");
+        }
+    }
+
+    void code_block(const char* info, const std::string& code)
+    {
+        if (open_code_block(info))
+        {
+            auto& cur = frames_.back();
+            write_code_block(info, code, cur.first_in_item);
+            frames_.pop_back();
+        }
+    }
+
+    // appends to the literal of the open inline code or code block
+    void literal(const char* str, std::size_t length)
+    {
+        assert(parent_type() == node_type::code || parent_type() == node_type::code_block);
+        literal_.append(str, length);
+    }
+
+    void literal(const std::string& str)
+    {
+        literal(str.c_str(), str.size());
+    }
+
+    // writes the pending data
+    void finish()
+    {
+        assert(frames_.size() == 1u);
+        // ensure final newline
+        if (last_ != '\n')
+            put('\n');
+        out_.write(buffer_.data(), std::streamsize(buffer_.size()));
+        buffer_.clear();
+    }
+
+private:
+    struct frame
+    {
+        node_type   type;
+        bool        in_tight;      // whether it is (inside) an item of a tight list
+        bool        tight;         // lists: whether the list is tight, items: of the parent list
+        bool        ordered;       // lists: whether the list is ordered
+        bool        has_children;  // whether a child has been added
+        bool        after_list;    // whether the last child is a list
+        bool        first_in_item; // whether it is the first child of an item
+        unsigned    number;        // lists: number of items, items: marker width
+        const char* delim;         // emphasis: delimiter, code blocks: info string
+
+        frame(node_type type, bool in_tight)
+        : type(type), in_tight(in_tight), tight(false), ordered(false), has_children(false),
+          after_list(false), first_in_item(false), number(0u), delim("")
+        {}
+    };
+
+    // whether a node of that type is in a tight list when it is a child of the current node
+    bool is_in_tight_list(node_type type) const noexcept
+    {
+        auto& parent = frames_.back();
+        if (!is_block(type))
+            return parent.in_tight;
+        else if (type == node_type::item)
+            return parent.tight;
+        else
+            return parent.type == node_type::item && parent.tight;
     }
 
+    // adds a new child to the current node
+    bool add_child(node_type type)
+    {
+        auto& parent = frames_.back();
+        if (!can_contain(parent.type, type))
+            return false;
+
+        if (parent.after_list)
+        {
+            parent.after_list = false;
+            if (type == node_type::code_block || type == node_type::list)
+            {
+                // ensures that the following block is not part of the list
+                cr();
+                if (flavor_ == commonmark)
+                {
+                    write_literal("<!-- end list -->");
+                    blankline();
+                }
+            }
+        }
+
+        return true;
+    }
+
+    bool push(node_type type, bool update_tight = true)
+    {
+        if (!add_child(type))
+            return false;
+
+        auto& parent = frames_.back();
+        frame f(type, is_in_tight_list(type));
+        f.first_in_item = parent.type == node_type::item && !parent.has_children;
+        if (type == node_type::item)
+            f.tight = parent.tight;
+        parent.has_children = true;
+
+        frames_.push_back(f);
+        if (update_tight)
+            in_tight_ = f.in_tight;
+        return true;
+    }
+
+    bool leaf(node_type type)
+    {
+        if (!add_child(type))
+            return false;
+
+        in_tight_                    = is_in_tight_list(type);
+        frames_.back().has_children = true;
+        return true;
+    }
+
+    //=== rendering ===//
+    void cr() noexcept
+    {
+        need_cr_ = std::max(need_cr_, 1u);
+    }
+
+    void blankline() noexcept
+    {
+        need_cr_ = std::max(need_cr_, 2u);
+    }
+
+    void write_code(const std::string& code)
+    {
+        in_tight_ = frames_.back().in_tight;
+        if (flavor_ == plaintext)
+        {
+            write(code.c_str(), code.size(), escaping::literal);
+            return;
+        }
+
+        // use a backtick sequence that doesn't appear in the code
+        auto used = 1u;
+        for (auto cur = code.begin(); cur != code.end();)
+        {
+            auto end = std::find_if(cur, code.end(), [](char c) { return c != '`'; });
+            if (end != cur && end - cur < 32)
+                used |= 1u << unsigned(end - cur);
+            cur = std::find(end, code.end(), '`');
+        }
+        auto ticks = 0u;
+        while (ticks < 32u && (used & 1u))
+        {
+            used >>= 1u;
+            ++ticks;
+        }
+
+        auto all_space   = code.find_first_not_of(' ') == std::string::npos;
+        auto extra_space = code.empty() || code.front() == '`' || code.back() == '`'
+                           || (!all_space && code.front() == ' ' && code.back() == ' ');
+
+        auto delim = std::string(ticks, '`');
+        write_literal(delim.c_str());
+        if (extra_space)
+            write_literal(" ");
+        write(code.c_str(), code.size(), escaping::literal);
+        if (extra_space)
+            write_literal(" ");
+        write_literal(delim.c_str());
+    }
+
+    void write_code_block(const char* info, const std::string& code, bool first_in_item)
+    {
+        in_tight_ = frames_.back().in_tight;
+        if (!first_in_item)
+            blankline();
+
+        if (flavor_ == plaintext)
+            write(code.c_str(), code.size(), escaping::literal);
+        else if (*info == '\0' && code.size() > 2u && !is_space(code.front())
+                 && !(is_space(code.back()) && is_space(code[code.size() - 2u])) && !first_in_item)
+        {
+            // indented code block
+            write_literal("    ");
+            prefix_ += "    ";
+            write(code.c_str(), code.size(), escaping::literal);
+            prefix_.resize(prefix_.size() - 4u);
+        }
+        else
+        {
+            auto longest = std::size_t(0);
+            for (auto cur = code.begin(); cur != code.end();)
+            {
+                auto end = std::find_if(cur, code.end(), [](char c) { return c != '`'; });
+                longest  = std::max(longest, std::size_t(end - cur));
+                cur      = std::find(end, code.end(), '`');
+            }
+
+            auto fence = std::string(std::max(longest + 1u, std::size_t(3u)),
+                                     std::strchr(info, '`') ? '~' : '`');
+            write_literal(fence.c_str());
+            write_literal(" ");
+            write_literal(info);
+            cr();
+            write(code.c_str(), code.size(), escaping::literal);
+            cr();
+            write_literal(fence.c_str());
+        }
+
+        blankline();
+    }
+
+    void write_literal(const char* str)
+    {
+        write(str, std::strlen(str), escaping::literal);
+    }
+
+    void write(const char* str, std::size_t length, escaping e)
+    {
+        if (in_tight_ && need_cr_ > 1u)
+            need_cr_ = 1u;
+        if (need_cr_ > 0u)
+        {
+            // existing newlines count as well
+            for (auto i = need_cr_ - std::min(need_cr_, newlines_); i > 0u; --i)
+            {
+                put('\n');
+                if (i > 1u)
+                    put(prefix_.c_str(), prefix_.size());
+            }
+
+            need_cr_       = 0u;
+            begin_line_    = true;
+            begin_content_ = true;
+        }
+
+        auto& special = specials.table[int(flavor_ == plaintext ? escaping::literal : e)];
+        auto  end     = str + length;
+        while (str != end)
+        {
+            if (begin_line_ || begin_content_ || special[static_cast<unsigned char>(*str)])
+            {
+                write_char(*str, str + 1 == end ? '\0' : str[1], e);
+                ++str;
+            }
+            else
+            {
+                // copy the run of ordinary characters
+                auto run_end = std::find_if(str, end, [&](char c) {
+                    return special[static_cast<unsigned char>(c)];
+                });
+                put(str, std::size_t(run_end - str));
+                str = run_end;
+            }
+        }
+    }
+
+    void write_char(char c, char next, escaping e)
+    {
+        if (begin_line_)
+            put(prefix_.c_str(), prefix_.size());
+
+        if (e == escaping::literal && c == '\n')
+        {
+            put(c);
+            begin_line_    = true;
+            begin_content_ = true;
+            return;
+        }
+        else if (e == escaping::literal || flavor_ == plaintext)
+            put(c);
+        else
+            write_escaped(c, next, e);
+
+        begin_line_    = false;
+        begin_content_ = begin_content_ && is_digit(c);
+    }
+
+    void write_escaped(char c, char next, escaping e)
+    {
+        auto follows_digit = is_digit(last_);
+
+        auto needs_escaping = false;
+        switch (e)
+        {
+        case escaping::normal:
+            needs_escaping
+                = std::strchr("*_[]#<>\\`~!", c) != nullptr || (c == '&' && is_alpha(next))
+                  || (begin_content_ && (c == '-' || c == '+' || c == '=') && !follows_digit)
+                  || (begin_content_ && (c == '.' || c == ')') && follows_digit
+                      && (next == '\0' || is_space(next)));
+            break;
+        case escaping::url:
+            needs_escaping = std::strchr("`<>\\()", c) != nullptr || is_space(c);
+            break;
+        case escaping::title:
+            needs_escaping = std::strchr("`<>\"\\", c) != nullptr;
+            break;
+        case escaping::literal:
+            break;
+        }
+
+        if (!needs_escaping)
+            put(c);
+        else if (e == escaping::url && is_space(c))
+        {
+            static constexpr char hex_digits[] = "0123456789ABCDEF";
+            put('%');
+            put(hex_digits[(static_cast<unsigned char>(c) >> 4) & 0xF]);
+            put(hex_digits[static_cast<unsigned char>(c) & 0xF]);
+        }
+        else
+        {
+            put('\\');
+            put(c);
+        }
+    }
+
+    void put(char c)
+    {
+        buffer_ += c;
+        last_     = c;
+        newlines_ = c == '\n' ? std::min(newlines_ + 1u, 2u) : 0u;
+    }
+
+    void put(const char* str, std::size_t length)
+    {
+        if (length == 0u)
+            return;
+        for (auto ptr = str; ptr != str + length; ++ptr)
+            if (*ptr == '\n')
+                newlines_ = std::min(newlines_ + 1u, 2u);
+            else
+                newlines_ = 0u;
+        buffer_.append(str, length);
+        last_ = str[length - 1u];
+    }
+
+    void flush_if_full()
+    {
+        if (buffer_.size() >= flush_size)
+        {
+            out_.write(buffer_.data(), std::streamsize(buffer_.size()));
+            buffer_.clear();
+        }
+    }
+
+    static constexpr std::size_t flush_size = 64u * 1024u;
+
+    std::string        buffer_;
+    std::string        prefix_;
+    std::string        literal_;
+    std::vector<frame> frames_;
+    std::ostream&      out_;
+    const options&     opt_;
+    flavor             flavor_;
+
+    unsigned need_cr_;  // number of line breaks before the next output
+    unsigned newlines_; // number of trailing newlines in the output, up to two
+    char     last_;     // last character in the output
+    bool     begin_line_, begin_content_, in_tight_;
+};
+
+void write_entity(markdown_writer& w, const entity& e);
+
+template <typename T>
+void write_children(markdown_writer& w, const T& container)
+{
+    for (auto& child : container)
+        write_entity(w, child);
+}
+
+void write(markdown_writer& w, const code_block& cb);
+void write_list_item(markdown_writer& w, const list_item_base& item);
+
+void write_documentation(markdown_writer& w, const documentation_entity& doc)
+{
+    if (w.opt().use_html)
+    {
+        std::string str = "<span id=\"standardese-";
+        detail::write_html_text(str, doc.id().as_output_str().c_str());
+        str += "\"></span>\n";
+        w.html_block(str);
+    }
+
+    if (doc.synopsis())
+        write(w, doc.synopsis().value());
+
+    if (auto brief = doc.brief_section())
+    {
+        if (w.open(node_type::paragraph))
+        {
+            write_children(w, brief.value());
+            w.close();
+        }
+    }
+
+    // write inline sections
+    for (auto& section : doc.doc_sections())
+        if (section.kind() != entity_kind::inline_section)
+            continue;
+        else if (w.open(node_type::paragraph))
+        {
+            auto& sec = static_cast<const inline_section&>(section);
+
+            // write section name
+            if (w.open_emph(false))
+            {
+                w.text(sec.name() + ":");
+                w.close();
+            }
+            w.text(" ", 1u);
+
+            // write section content
+            write_children(w, sec);
+            w.close();
+        }
+
     // write details section
     if (auto details = doc.details_section())
-        handle_children(parent, opt, details.value());
+        write_children(w, details.value());
 
     // write list sections
     for (auto& section : doc.doc_sections())
@@ -136,51 +865,40 @@ void build_documentation(cmark_node* parent, const options& opt, const documenta
             auto& list = static_cast<const list_section&>(section);
 
             // heading
-            auto heading = build_heading(4, list.name().c_str());
-            cmark_node_append_child(parent, heading);
+            if (w.open_heading(4u))
+            {
+                w.text(list.name());
+                w.close();
+            }
 
             // list
-            auto ul = cmark_node_new(CMARK_NODE_LIST);
-            cmark_node_set_list_type(ul, CMARK_BULLET_LIST);
-            cmark_node_set_list_tight(ul, 1);
-            cmark_node_append_child(parent, ul);
-
-            for (auto& item : list)
-                build_list_item(ul, opt, item);
+            if (w.open_list(false, true))
+            {
+                for (auto& item : list)
+                    write_list_item(w, item);
+                w.close();
+            }
         }
 }
 
-void append_module(cmark_node* heading, const std::string& module)
+void write_doc_header(markdown_writer& w, const documentation_entity& doc, unsigned level)
 {
-    auto text = cmark_node_new(CMARK_NODE_TEXT);
-    cmark_node_set_literal(text, (" [" + module + "]").c_str());
-    cmark_node_append_child(heading, text);
-}
-
-void build_doc_header(cmark_node* parent, const options& opt, const documentation_header& header,
-                      unsigned level)
-{
-    auto heading = build_heading(level, nullptr);
-    cmark_node_append_child(parent, heading);
-
-    handle_children(heading, opt, header.heading());
+    if (!doc.header() || !w.open_heading(level))
+        return;
 
+    auto& header = doc.header().value();
+    write_children(w, header.heading());
     if (header.module())
-        append_module(heading, header.module().value());
-}
+        w.text(" [" + header.module().value() + "]");
 
-void build_doc_header(cmark_node* parent, const options& opt, const documentation_entity& doc,
-                      unsigned level)
-{
-    if (doc.header())
-        build_doc_header(parent, opt, doc.header().value(), level);
+    w.close();
 }
 
-void build(cmark_node* parent, const options& opt, const file_documentation& doc)
+void write(markdown_writer& w, const file_documentation& doc)
 {
-    build_doc_header(parent, opt, doc, 1);
-    build_documentation(parent, opt, doc);
-    handle_children(parent, opt, doc);
+    write_doc_header(w, doc, 1u);
+    write_documentation(w, doc);
+    write_children(w, doc);
 }
 
 unsigned get_documentation_heading_level(const documentation_entity& doc)
@@ -194,399 +912,420 @@ unsigned get_documentation_heading_level(const documentation_entity& doc)
     return 2;
 }
 
-void build(cmark_node* parent, const options& opt, const entity_documentation& doc)
+void write(markdown_writer& w, const entity_documentation& doc)
 {
-    build_doc_header(parent, opt, doc, get_documentation_heading_level(doc));
-    build_documentation(parent, opt, doc);
-    handle_children(parent, opt, doc);
+    write_doc_header(w, doc, get_documentation_heading_level(doc));
+    write_documentation(w, doc);
+    write_children(w, doc);
 
     if (doc.header())
-        cmark_node_append_child(parent, cmark_node_new(CMARK_NODE_THEMATIC_BREAK));
+        w.thematic_break();
 }
 
-void build(cmark_node* parent, const options& opt, const entity_index_item& item);
-void build(cmark_node* parent, const options& opt, const namespace_documentation& doc);
-void build(cmark_node* parent, const options& opt, const module_documentation& doc);
+void write(markdown_writer& w, const entity_index_item& item);
+void write(markdown_writer& w, const namespace_documentation& doc);
+void write(markdown_writer& w, const module_documentation& doc);
 
-void build_index_child(cmark_node* parent, const options& opt, const block_entity& child)
+void write_index_child(markdown_writer& w, const block_entity& child)
 {
     if (child.kind() == entity_kind::entity_index_item)
-        build(parent, opt, static_cast<const entity_index_item&>(child));
+        write(w, static_cast<const entity_index_item&>(child));
     else if (child.kind() == entity_kind::namespace_documentation)
-        build(parent, opt, static_cast<const namespace_documentation&>(child));
+        write(w, static_cast<const namespace_documentation&>(child));
     else if (child.kind() == entity_kind::module_documentation)
-        build(parent, opt, static_cast<const module_documentation&>(child));
+        write(w, static_cast<const module_documentation&>(child));
     else
         assert(false);
 }
 
 template <class T>
-void build_module_ns(cmark_node* parent, const options& opt, const T& doc)
+void write_module_ns(markdown_writer& w, const T& doc)
 {
-    auto item = cmark_node_new(CMARK_NODE_ITEM);
-    cmark_node_append_child(parent, item);
+    if (!w.open_item())
+        return;
 
-    build_doc_header(item, opt, doc, get_documentation_heading_level(doc));
-    build_documentation(item, opt, doc);
+    write_doc_header(w, doc, get_documentation_heading_level(doc));
+    write_documentation(w, doc);
 
-    auto list = cmark_node_new(CMARK_NODE_LIST);
-    cmark_node_set_list_type(list, CMARK_BULLET_LIST);
-    cmark_node_append_child(item, list);
+    if (w.open_list(false, false))
+    {
+        for (auto& child : doc)
+            write_index_child(w, child);
+        w.close();
+    }
 
-    for (auto& child : doc)
-        build_index_child(list, opt, child);
+    w.close();
 }
 
-void build(cmark_node* parent, const options& opt, const namespace_documentation& doc)
+void write(markdown_writer& w, const namespace_documentation& doc)
 {
-    build_module_ns(parent, opt, doc);
+    write_module_ns(w, doc);
 }
 
-void build(cmark_node* parent, const options& opt, const module_documentation& doc)
+void write(markdown_writer& w, const module_documentation& doc)
 {
-    build_module_ns(parent, opt, doc);
+    write_module_ns(w, doc);
 }
 
-void build_term_description(cmark_node* parent, const options& opt, const term& t,
-                            const description* desc);
+void write_term_description(markdown_writer& w, const term& t, const description* desc);
 
-void build(cmark_node* parent, const options& opt, const entity_index_item& item)
+void write(markdown_writer& w, const entity_index_item& item)
 {
-    auto node = cmark_node_new(CMARK_NODE_ITEM);
-    cmark_node_append_child(parent, node);
-    build_term_description(node, opt, item.entity(),
-                           item.brief() ? &item.brief().value() : nullptr);
+    if (w.open_item())
+    {
+        write_term_description(w, item.entity(), item.brief() ? &item.brief().value() : nullptr);
+        w.close();
+    }
 }
 
 template <class Index>
-void build_index(cmark_node* parent, const options& opt, const Index& index)
+void write_index(markdown_writer& w, const Index& index)
 {
-    auto heading = build_heading(1, nullptr);
-    cmark_node_append_child(parent, heading);
-    handle_children(heading, opt, index.heading());
-
-    auto list = cmark_node_new(CMARK_NODE_LIST);
-    cmark_node_set_list_type(list, CMARK_BULLET_LIST);
-    cmark_node_append_child(parent, list);
+    if (w.open_heading(1u))
+    {
+        write_children(w, index.heading());
+        w.close();
+    }
 
-    for (auto& child : index)
-        build_index_child(list, opt, child);
+    if (w.open_list(false, false))
+    {
+        for (auto& child : index)
+            write_index_child(w, child);
+        w.close();
+    }
 }
 
-void build(cmark_node* parent, const options& opt, const file_index& index)
+void write(markdown_writer& w, const file_index& index)
 {
-    build_index(parent, opt, index);
+    write_index(w, index);
 }
 
-void build(cmark_node* parent, const options& opt, const entity_index& index)
+void write(markdown_writer& w, const entity_index& index)
 {
-    build_index(parent, opt, index);
+    write_index(w, index);
 }
 
-void build(cmark_node* parent, const options& opt, const module_index& index)
+void write(markdown_writer& w, const module_index& index)
 {
-    build_index(parent, opt, index);
+    write_index(w, index);
 }
 
-void build(cmark_node* parent, const options& opt, const heading& h)
+void write(markdown_writer& w, const heading& h)
 {
-    auto heading = build_heading(4, nullptr);
-    cmark_node_append_child(parent, heading);
-    handle_children(heading, opt, h);
+    if (w.open_heading(4u))
+    {
+        write_children(w, h);
+        w.close();
+    }
 }
 
-void build(cmark_node* parent, const options& opt, const subheading& h)
+void write(markdown_writer& w, const subheading& h)
 {
-    auto heading = build_heading(5, nullptr);
-    cmark_node_append_child(parent, heading);
-    handle_children(heading, opt, h);
+    if (w.open_heading(5u))
+    {
+        write_children(w, h);
+        w.close();
+    }
 }
 
-void build(cmark_node* parent, const options& opt, const paragraph& par)
+void write(markdown_writer& w, const paragraph& par)
 {
-    auto node = cmark_node_new(CMARK_NODE_PARAGRAPH);
-    cmark_node_append_child(parent, node);
-    handle_children(node, opt, par);
+    if (w.open(node_type::paragraph))
+    {
+        write_children(w, par);
+        w.close();
+    }
 }
 
-void build_term_description(cmark_node* parent, const options& opt, const term& t,
-                            const description* desc)
+void write_term_description(markdown_writer& w, const term& t, const description* desc)
 {
-    auto paragraph = cmark_node_new(CMARK_NODE_PARAGRAPH);
-    cmark_node_append_child(parent, paragraph);
+    if (!w.open(node_type::paragraph))
+        return;
 
-    handle_children(paragraph, opt, t);
+    write_children(w, t);
 
     if (desc)
     {
-        if (opt.use_html)
-        {
-            auto html = cmark_node_new(CMARK_NODE_HTML_INLINE);
-            cmark_node_set_literal(html, " &mdash; ");
-            cmark_node_append_child(paragraph, html);
-        }
+        if (w.opt().use_html)
+            w.html_inline(" &mdash; ");
         else
-        {
-            auto text = cmark_node_new(CMARK_NODE_TEXT);
-            cmark_node_set_literal(text, " - ");
-            cmark_node_append_child(paragraph, text);
-        }
+            w.text(" - ", 3u);
 
-        handle_children(paragraph, opt, *desc);
+        write_children(w, *desc);
     }
+
+    w.close();
 }
 
-void build_list_item(cmark_node* parent, const options& opt, const list_item_base& item)
+void write_list_item(markdown_writer& w, const list_item_base& item)
 {
-    auto li = cmark_node_new(CMARK_NODE_ITEM);
-    cmark_node_append_child(parent, li);
+    if (!w.open_item())
+        return;
 
     if (item.kind() == entity_kind::list_item)
-        handle_children(li, opt, static_cast<const list_item&>(item));
+        write_children(w, static_cast<const list_item&>(item));
     else if (item.kind() == entity_kind::term_description_item)
     {
         auto& term        = static_cast<const term_description_item&>(item).term();
         auto& description = static_cast<const term_description_item&>(item).description();
-        build_term_description(li, opt, term, &description);
+        write_term_description(w, term, &description);
     }
     else
         assert(false);
-}
 
-void build(cmark_node* parent, const options& opt, const unordered_list& list)
-{
-    auto ul = cmark_node_new(CMARK_NODE_LIST);
-    cmark_node_set_list_type(ul, CMARK_BULLET_LIST);
-    cmark_node_append_child(parent, ul);
-
-    for (auto& item : list)
-        build_list_item(ul, opt, item);
+    w.close();
 }
 
-void build(cmark_node* parent, const options& opt, const ordered_list& list)
+void write(markdown_writer& w, const unordered_list& list)
 {
-    auto ul = cmark_node_new(CMARK_NODE_LIST);
-    cmark_node_set_list_type(ul, CMARK_ORDERED_LIST);
-    cmark_node_set_list_start(ul, 1);
-    cmark_node_append_child(parent, ul);
-
-    for (auto& item : list)
-        build_list_item(ul, opt, item);
+    if (w.open_list(false, false))
+    {
+        for (auto& item : list)
+            write_list_item(w, item);
+        w.close();
+    }
 }
 
-void build(cmark_node* parent, const options& opt, const block_quote& quote)
+void write(markdown_writer& w, const ordered_list& list)
 {
-    auto node = cmark_node_new(CMARK_NODE_BLOCK_QUOTE);
-    cmark_node_append_child(parent, node);
-
-    handle_children(node, opt, quote);
+    if (w.open_list(true, false))
+    {
+        for (auto& item : list)
+            write_list_item(w, item);
+        w.close();
+    }
 }
 
-void build(cmark_node* parent, const options& opt, const code_block& cb)
+void write(markdown_writer& w, const block_quote& quote)
 {
-    if (opt.use_html)
+    if (w.open(node_type::block_quote))
     {
-        auto node = cmark_node_new(CMARK_NODE_HTML_BLOCK);
-        cmark_node_append_child(parent, node);
-
-        auto html = render(html_generator(opt.prefix, opt.extension), cb);
-        cmark_node_set_literal(node, html.c_str());
+        write_children(w, quote);
+        w.close();
     }
-    else
-    {
-        auto node = cmark_node_new(CMARK_NODE_CODE_BLOCK);
-        cmark_node_append_child(parent, node);
-
-        if (!cb.language().empty())
-            cmark_node_set_fence_info(node, cb.language().c_str());
+}
 
-        handle_children(node, opt, cb);
+void write(markdown_writer& w, const code_block& cb)
+{
+    if (w.opt().use_html)
+        w.html_block(render(html_generator(w.opt().prefix, w.opt().extension), cb));
+    else if (cb.is_compact())
+        // links only write their content inside a code block,
+        // so the literal is just the code
+        w.code_block(cb.language().c_str(), cb.code());
+    else if (w.open_code_block(cb.language().c_str()))
+    {
+        write_children(w, cb);
+        w.close();
     }
 }
 
-void append_code_block_text(cmark_node* cb, const std::string& text)
+void write_code_block_text(markdown_writer& w, const std::string& text)
 {
-    auto str = cmark_node_get_literal(cb);
-    if (str)
-        cmark_node_set_literal(cb, (str + text).c_str());
-    else
-        cmark_node_set_literal(cb, text.c_str());
+    // tokens only have a meaning inside a code block
+    if (w.parent_type() == node_type::code_block || w.parent_type() == node_type::code)
+        w.literal(text);
 }
 
-void build(cmark_node* parent, const options&, const code_block::keyword& text)
+void write(markdown_writer& w, const code_block::keyword& text)
 {
-    append_code_block_text(parent, text.string());
+    write_code_block_text(w, text.string());
 }
 
-void build(cmark_node* parent, const options&, const code_block::identifier& text)
+void write(markdown_writer& w, const code_block::identifier& text)
 {
-    append_code_block_text(parent, text.string());
+    write_code_block_text(w, text.string());
 }
 
-void build(cmark_node* parent, const options&, const code_block::string_literal& text)
+void write(markdown_writer& w, const code_block::string_literal& text)
 {
-    append_code_block_text(parent, text.string());
+    write_code_block_text(w, text.string());
 }
 
-void build(cmark_node* parent, const options&, const code_block::int_literal& text)
+void write(markdown_writer& w, const code_block::int_literal& text)
 {
-    append_code_block_text(parent, text.string());
+    write_code_block_text(w, text.string());
 }
 
-void build(cmark_node* parent, const options&, const code_block::float_literal& text)
+void write(markdown_writer& w, const code_block::float_literal& text)
 {
-    append_code_block_text(parent, text.string());
+    write_code_block_text(w, text.string());
 }
 
-void build(cmark_node* parent, const options&, const code_block::punctuation& text)
+void write(markdown_writer& w, const code_block::punctuation& text)
 {
-    append_code_block_text(parent, text.string());
+    write_code_block_text(w, text.string());
 }
 
-void build(cmark_node* parent, const options&, const code_block::preprocessor& text)
+void write(markdown_writer& w, const code_block::preprocessor& text)
 {
-    append_code_block_text(parent, text.string());
+    write_code_block_text(w, text.string());
 }
 
-void build(cmark_node* parent, const options&, const thematic_break&)
+void write(markdown_writer& w, const thematic_break&)
 {
-    auto node = cmark_node_new(CMARK_NODE_THEMATIC_BREAK);
-    cmark_node_append_child(parent, node);
+    w.thematic_break();
 }
 
-void build(cmark_node* parent, const options&, const text& t)
+void write(markdown_writer& w, const text& t)
 {
-    if (cmark_node_get_type(parent) == CMARK_NODE_CODE_BLOCK
-        || cmark_node_get_type(parent) == CMARK_NODE_CODE)
-        append_code_block_text(parent, t.string());
+    if (w.parent_type() == node_type::code_block || w.parent_type() == node_type::code)
+        w.literal(t.string());
     else
-    {
-        auto text = cmark_node_new(CMARK_NODE_TEXT);
-        cmark_node_append_child(parent, text);
-        cmark_node_set_literal(text, t.string().c_str());
-    }
+        w.text(t.string());
 }
 
-void build(cmark_node* parent, const options& opt, const emphasis& emph)
+bool is_only_child(const phrasing_entity& e)
 {
-    auto node = cmark_node_new(CMARK_NODE_EMPH);
-    cmark_node_append_child(parent, node);
+    if (!e.parent() || e.parent().value().kind() != entity_kind::emphasis)
+        return false;
 
-    handle_children(node, opt, emph);
+    auto& parent = static_cast<const emphasis&>(e.parent().value());
+    auto  begin  = parent.begin();
+    return begin != parent.end() && ++begin == parent.end();
 }
 
-void build(cmark_node* parent, const options& opt, const strong_emphasis& emph)
+void write(markdown_writer& w, const emphasis& emph)
 {
-    auto node = cmark_node_new(CMARK_NODE_STRONG);
-    cmark_node_append_child(parent, node);
+    if (w.open_emph(is_only_child(emph)))
+    {
+        write_children(w, emph);
+        w.close();
+    }
+}
 
-    handle_children(node, opt, emph);
+void write(markdown_writer& w, const strong_emphasis& emph)
+{
+    if (w.open(node_type::strong))
+    {
+        write_children(w, emph);
+        w.close();
+    }
 }
 
-void build(cmark_node* parent, const options& opt, const code& c)
+void write(markdown_writer& w, const code& c)
 {
-    auto node = cmark_node_new(CMARK_NODE_CODE);
-    cmark_node_append_child(parent, node);
-    handle_children(node, opt, c);
+    if (w.open_code())
+    {
+        write_children(w, c);
+        w.close();
+    }
 }
 
-void build(cmark_node* parent, const options&, const verbatim& v)
+void write(markdown_writer& w, const verbatim& v)
 {
-    // build inline HTML and hope it works
-    auto node = cmark_node_new(CMARK_NODE_HTML_INLINE);
-    cmark_node_append_child(parent, node);
-    cmark_node_set_literal(node, v.content().c_str());
+    // write inline HTML and hope it works
+    w.html_inline(v.content());
 }
 
-void build(cmark_node* parent, const options&, const soft_break&)
+void write(markdown_writer& w, const soft_break&)
 {
-    if (cmark_node_get_type(parent) == CMARK_NODE_CODE_BLOCK)
-        append_code_block_text(parent, "\n");
+    if (w.parent_type() == node_type::code_block)
+        w.literal("\n", 1u);
     else
-    {
-        auto node = cmark_node_new(CMARK_NODE_SOFTBREAK);
-        cmark_node_append_child(parent, node);
-    }
+        w.soft_break();
 }
 
-void build(cmark_node* parent, const options&, const hard_break&)
+void write(markdown_writer& w, const hard_break&)
 {
-    if (cmark_node_get_type(parent) == CMARK_NODE_CODE_BLOCK)
-        append_code_block_text(parent, "\n");
+    if (w.parent_type() == node_type::code_block)
+        w.literal("\n", 1u);
     else
-    {
-        auto node = cmark_node_new(CMARK_NODE_LINEBREAK);
-        cmark_node_append_child(parent, node);
-    }
+        w.line_break();
 }
 
-cmark_node* build_link(const char* title, const char* url)
+// whether the URL starts with a scheme
+bool has_scheme(const std::string& url)
 {
-    auto node = cmark_node_new(CMARK_NODE_LINK);
-    if (*title != '\0')
-        cmark_node_set_title(node, title);
-    cmark_node_set_url(node, url);
+    if (url.empty() || !is_alpha(url.front()))
+        return false;
+
+    auto length = std::find_if_not(url.begin() + 1, url.end(),
+                                   [](char c) {
+                                       return is_alpha(c) || is_digit(c) || c == '.' || c == '+'
+                                              || c == '-';
+                                   })
+                  - url.begin();
+    return length >= 2 && length <= 32 && std::size_t(length) < url.size()
+           && url[std::size_t(length)] == ':';
+}
 
-    return node;
+// whether the link can be written as <url>, i.e. its text is the URL itself
+template <class Link>
+bool is_autolink(const Link& link, const std::string& url)
+{
+    if (!link.title().empty() || !has_scheme(url))
+        return false;
+
+    std::string content;
+    auto        has_text = false;
+    for (auto& child : link)
+        if (child.kind() != entity_kind::text)
+            break;
+        else
+        {
+            content += static_cast<const text&>(child).string();
+            has_text = true;
+        }
+
+    auto expected = url.compare(0u, 7u, "mailto:") == 0 ? url.substr(7u) : url;
+    return has_text && content == expected;
 }
 
-void build(cmark_node* parent, const options& opt, const external_link& link)
+template <class Link>
+void write_link(markdown_writer& w, const Link& link, const std::string& url)
 {
-    if (cmark_node_get_type(parent) == CMARK_NODE_CODE_BLOCK)
-        handle_children(parent, opt, link);
-    else
+    if (w.output_flavor() == markdown_writer::commonmark && is_autolink(link, url))
+        w.autolink(url);
+    else if (w.open(node_type::link))
     {
-        auto node = build_link(link.title().c_str(), link.url().as_str().c_str());
-        cmark_node_append_child(parent, node);
-
-        handle_children(node, opt, link);
+        write_children(w, link);
+        w.close_link(url, link.title());
     }
 }
 
-void build(cmark_node* parent, const options& opt, const documentation_link& link)
+void write(markdown_writer& w, const external_link& link)
 {
-    if (cmark_node_get_type(parent) == CMARK_NODE_CODE_BLOCK)
-        handle_children(parent, opt, link);
+    if (w.parent_type() == node_type::code_block)
+        write_children(w, link);
+    else
+        write_link(w, link, link.url().as_str());
+}
+
+void write(markdown_writer& w, const documentation_link& link)
+{
+    if (w.parent_type() == node_type::code_block)
+        write_children(w, link);
     else if (link.internal_destination())
     {
-        auto url = opt.prefix
-                   + link.internal_destination()
-                         .value()
-                         .document()
-                         .map(&output_name::file_name, opt.extension.c_str())
-                         .value_or("");
-        url += "#standardese-" + link.internal_destination().value().id().as_output_str();
+        auto& dest = link.internal_destination().value();
 
-        auto node = build_link(link.title().c_str(), url.c_str());
-        cmark_node_append_child(parent, node);
+        auto url = w.opt().prefix;
+        if (dest.document())
+            url += dest.document().value().file_name(w.opt().extension.c_str());
+        url += "#standardese-";
+        dest.id().append_output_str(url);
 
-        handle_children(node, opt, link);
+        write_link(w, link, url);
     }
     else if (link.external_destination())
-    {
-        auto url = link.external_destination().value().as_str();
-
-        auto node = build_link(link.title().c_str(), url.c_str());
-        cmark_node_append_child(parent, node);
-
-        handle_children(node, opt, link);
-    }
+        write_link(w, link, link.external_destination().value().as_str());
     else
         // only write link content
-        handle_children(parent, opt, link);
+        write_children(w, link);
 }
 
-void build_entity(cmark_node* parent, const options& opt, const entity& e)
+void write_entity(markdown_writer& w, const entity& e)
 {
     switch (e.kind())
     {
 #define STANDARDESE_DETAIL_HANDLE(Kind)                                                            \
     case entity_kind::Kind:                                                                        \
-        build(parent, opt, static_cast<const Kind&>(e));                                           \
+        write(w, static_cast<const Kind&>(e));                                                     \
         break;
 #define STANDARDESE_DETAIL_HANDLE_CODE_BLOCK(Kind)                                                 \
     case entity_kind::code_block_##Kind:                                                           \
-        build(parent, opt, static_cast<const code_block::Kind&>(e));                               \
+        write(w, static_cast<const code_block::Kind&>(e));                                         \
         break;
 
         STANDARDESE_DETAIL_HANDLE(file_documentation)
@@ -650,18 +1389,18 @@ void build_entity(cmark_node* parent, const options& opt, const entity& e)
     }
 }
 
-cmark_node* build_entity(const options& opt, const entity& e)
+void write_root(std::ostream& out, const options& opt, markdown_writer::flavor f, const entity& e)
 {
-    auto doc = is_phrasing(e.kind()) ? cmark_node_new(CMARK_NODE_PARAGRAPH)
-                                     : cmark_node_new(CMARK_NODE_DOCUMENT);
+    markdown_writer w(out, opt, f,
+                      is_phrasing(e.kind()) ? node_type::paragraph : node_type::document);
 
     if (e.kind() == entity_kind::main_document || e.kind() == entity_kind::subdocument
         || e.kind() == entity_kind::template_document)
-        handle_children(doc, opt, static_cast<const document_entity&>(e));
+        write_children(w, static_cast<const document_entity&>(e));
     else
-        build_entity(doc, opt, e);
+        write_entity(w, e);
 
-    return doc;
+    w.finish();
 }
 } // namespace
 
@@ -670,13 +1409,7 @@ generator standardese::markup::markdown_generator(bool use_html, const std::stri
 {
     options opt{prefix, extension, use_html};
     return [opt](std::ostream& out, const entity& e) {
-        auto doc = build_entity(opt, e);
-
-        auto str = cmark_render_commonmark(doc, CMARK_OPT_NOBREAKS, 0);
-        out << str;
-        std::free(str);
-
-        cmark_node_free(doc);
+        write_root(out, opt, markdown_writer::commonmark, e);
     };
 }
 
@@ -684,12 +1417,6 @@ generator standardese::markup::text_generator() noexcept
 {
     options opt{"", "txt", false};
     return [opt](std::ostream& out, const entity& e) {
-        auto doc = build_entity(opt, e);
-
-        auto str = cmark_render_plaintext(doc, CMARK_OPT_NOBREAKS, 0);
-        out << str;
-        std::free(str);
-
-        cmark_node_free(doc);
+        write_root(out, opt, markdown_writer::plaintext, e);
     };
 }
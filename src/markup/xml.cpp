@@ -4,6 +4,7 @@
 
 #include <standardese/markup/generator.hpp>
 
+#include <cstring>
 #include <ostream>
 
 #include <type_safe/flag.hpp>
@@ -82,7 +83,12 @@ public:
     // writes XML escaped text
     void write(const char* str)
     {
-        for (auto ptr = str; *ptr; ++ptr)
+        write(str, std::strlen(str));
+    }
+
+    void write(const char* str, std::size_t length)
+    {
+        for (auto ptr = str; ptr != str + length; ++ptr)
         {
             auto c = *ptr;
             if (c == '&')
@@ -102,7 +108,7 @@ public:
 
     void write(const std::string& str)
     {
-        write(str.c_str());
+        write(str.c_str(), str.size());
     }
 
     // writes unescaped xml
@@ -193,6 +199,7 @@ void write(xml_stream& s, const template_document& doc)
 
 void write(xml_stream& s, const heading& h);
 void write(xml_stream& s, const code_block& cb);
+void write(xml_stream& s, const documentation_link& link);
 
 template <class Documentation>
 void write_documentation(xml_stream& s, const Documentation& doc, const char* tag_name)
@@ -318,12 +325,59 @@ void write(xml_stream& s, const block_quote& quote)
     write_block(s, "block-quote", quote);
 }
 
+const char* get_token_tag(code_block::token_kind kind) noexcept
+{
+    switch (kind)
+    {
+    case code_block::token_kind::keyword:
+        return "code-block-keyword";
+    case code_block::token_kind::identifier:
+        return "code-block-identifier";
+    case code_block::token_kind::string_literal:
+        return "code-block-string-literal";
+    case code_block::token_kind::int_literal:
+        return "code-block-int-literal";
+    case code_block::token_kind::float_literal:
+        return "code-block-float-literal";
+    case code_block::token_kind::punctuation:
+        return "code-block-punctuation";
+    case code_block::token_kind::preprocessor:
+        return "code-block-preprocessor";
+
+    case code_block::token_kind::text:
+    case code_block::token_kind::soft_break:
+    case code_block::token_kind::link:
+        break;
+    }
+
+    return nullptr;
+}
+
+void write_tokens(xml_stream& s, const code_block& code)
+{
+    for (auto& tok : code.tokens())
+        if (tok.kind() == code_block::token_kind::link)
+            write(s, code.link(tok));
+        else if (tok.kind() == code_block::token_kind::soft_break)
+            s.open_tag(xml_stream::line_tag, "soft-break");
+        else if (auto tag_name = get_token_tag(tok.kind()))
+        {
+            auto tag = s.open_tag(xml_stream::inline_tag, tag_name);
+            tag.write(code.code().data() + tok.offset(), tok.length());
+        }
+        else
+            s.write(code.code().data() + tok.offset(), tok.length());
+}
+
 void write(xml_stream& s, const code_block& code)
 {
     auto tag = s.open_tag(xml_stream::line_tag, "code-block",
                           std::make_pair("id", code.id().as_output_str()),
                           std::make_pair("language", code.language()));
-    write_children(tag, code);
+    if (code.is_compact())
+        write_tokens(tag, code);
+    else
+        write_children(tag, code);
 }
 
 template <typename T>
@@ -286,6 +286,82 @@ TEST_CASE("comment")
         const auto& group = comments.lookup_group("Arithmetic");
         CHECK(static_cast<size_t>(group.size()) == 2);
     }
+
+    SECTION("unique name cache")
+    {
+        auto file = parse_file({}, "comment_unique_name_cache.cpp", R"(
+            namespace ns
+            {
+                /// \unique_name *renamed
+                struct a
+                {
+                    template <typename T>
+                    struct b
+                    {
+                        void c(int i, float);
+                    };
+                };
+
+                /// \unique_name absolute
+                struct d
+                {
+                    void e();
+                };
+            }
+            )");
+
+        file_comment_parser parser(test_logger());
+        parser.parse(type_safe::ref(*file));
+        auto registry = parser.finish();
+
+        unique_name_cache cache(registry);
+        cppast::visit(*file, [&](const cppast::cpp_entity& e, const cppast::visitor_info&) {
+            INFO(e.name());
+            REQUIRE(cache.lookup_unique_name(e) == lookup_unique_name(registry, e));
+            if (cppast::is_function(e.kind()))
+                for (auto& param : static_cast<const cppast::cpp_function_base&>(e).parameters())
+                    REQUIRE(cache.lookup_unique_name(param) == lookup_unique_name(registry, param));
+            return true;
+        });
+    }
+    SECTION("deferred parse error")
+    {
+        auto file = parse_file({}, "comment_deferred_parse_error.cpp", R"(
+            /// \brief A brief.
+            ///
+            /// Details.
+            ///
+            /// \brief Another brief.
+            void a();
+            )");
+
+        class counting_logger : public cppast::diagnostic_logger
+        {
+        public:
+            mutable unsigned count = 0;
+
+        private:
+            bool do_log(const char*, const cppast::diagnostic&) const override
+            {
+                ++count;
+                return true;
+            }
+        } logger;
+
+        file_comment_parser parser(type_safe::ref(logger));
+        parser.parse(type_safe::ref(*file));
+        auto registry = parser.finish();
+
+        auto comment = registry.get_comment(*file->begin());
+        REQUIRE(comment.has_value());
+        // the markup is only parsed once the sections are accessed
+        REQUIRE(logger.count == 0u);
+
+        // the error is logged and the comment documents it instead of throwing
+        REQUIRE(comment.value().brief_section().has_value());
+        REQUIRE(comment.value().sections().empty());
+        REQUIRE(logger.count == 1u);
+    }
 }
 
 }
@@ -10,6 +10,7 @@
 
 #include "../../include/standardese/comment/parser.hpp"
 #include "standardese/comment/config.hpp"
+#include "standardese/markup/arena.hpp"
 
 namespace standardese::test::comment {
 
@@ -1110,4 +1111,186 @@ TEST_CASE("Standardese Commands", "[comment]")
     }
 }
 
+TEST_CASE("Command Syntax can be Configured", "[comment]")
+{
+    SECTION("Commands can use a Different Command Character")
+    {
+        standardese::comment::config::options options;
+        options.command_character = '@';
+
+        const auto parsed = parse(R"(
+            A brief.
+            @returns A return value.
+            \returns Not a command.
+            )", options);
+
+        CHECK_SECTIONS_EQUIVALENT_TO(parsed, R"(
+            <inline-section name="Return values">A return value.<soft-break></soft-break>
+            \returns Not a command.</inline-section>
+            )");
+    }
+    SECTION("Command Patterns can be Replaced")
+    {
+        standardese::comment::config::options options;
+        options.command_patterns.push_back("brief=SUMMARY:");
+
+        const auto parsed = parse(R"(
+            SUMMARY: The brief.
+            \brief Not a command.
+            )", options);
+
+        CHECK_BRIEF_EQUIVALENT_TO(parsed, R"(
+            <brief-section>The brief.<soft-break></soft-break>
+            \brief Not a command.</brief-section>
+            )");
+    }
+}
+
+TEST_CASE("Parser Reuse", "[comment]")
+{
+    const parser p;
+
+    SECTION("Consecutive Comments are Parsed Independently")
+    {
+        const auto first = parse(p, unindent(R"(
+            \returns A return value.
+            )"), true);
+        const auto second = parse(p, unindent(R"(
+            \returns Another return value.
+            )"), true);
+
+        CHECK_SECTIONS_EQUIVALENT_TO(first, R"(
+            <inline-section name="Return values">A return value.</inline-section>
+            )");
+        CHECK_SECTIONS_EQUIVALENT_TO(second, R"(
+            <inline-section name="Return values">Another return value.</inline-section>
+            )");
+    }
+
+    SECTION("A Parse Error does not Affect Later Comments")
+    {
+        CHECK_THROWS_AS(parse(p, R"(![an image](img.png))", true), parse_error);
+
+        const auto parsed = parse(p, "A brief.", true);
+        CHECK_BRIEF_EQUIVALENT_TO(parsed, R"(
+            <brief-section>A brief.</brief-section>
+            )");
+    }
+}
+
+TEST_CASE("Parse Cache", "[comment]")
+{
+    standardese::comment::parse_cache cache;
+    const auto parsers = std::make_shared<const standardese::comment::parser_pool>();
+
+    // only a text that has been seen before is kept
+    const auto first = cache.parse(parsers, R"(\effects Does something.)", true);
+    const auto second = cache.parse(parsers, R"(\effects Does something.)", true);
+    CHECK(cache.misses() == 2);
+    CHECK(cache.hits() == 0);
+
+    const auto third = cache.parse(parsers, R"(\effects Does something.)", true);
+    CHECK(cache.misses() == 2);
+    CHECK(cache.hits() == 1);
+
+    for (const auto* parsed : {&first, &second, &third})
+        CHECK_SECTIONS_EQUIVALENT_TO(*parsed, R"(
+            <inline-section name="Effects">Does something.</inline-section>
+            )");
+
+    SECTION("Comments are Cached per Configuration")
+    {
+        standardese::comment::config::options options;
+        options.command_character = '@';
+        const auto other = std::make_shared<const standardese::comment::parser_pool>(
+            standardese::comment::config{options});
+
+        const auto parsed = cache.parse(other, R"(\effects Does something.)", true);
+        CHECK(cache.misses() == 3);
+        CHECK_BRIEF_EQUIVALENT_TO(parsed, R"(
+            <brief-section>\effects Does something.</brief-section>
+            )");
+    }
+}
+
+TEST_CASE("Deferred Markup", "[comment]")
+{
+    const auto parsers = std::make_shared<const standardese::comment::parser_pool>();
+
+    SECTION("Comments without Metadata are Parsed on Demand")
+    {
+        const auto parsed = parse(parsers, unindent(R"(
+            A brief.
+
+            \returns A return value.
+            )"), true);
+
+        REQUIRE(parsed.comment.has_value());
+        CHECK(parsed.comment.value().metadata().is_empty());
+        CHECK(parsed.comment.value().has_sections());
+        CHECK(parsed.comment.value().is_deferred());
+
+        const auto copy = clone(parsed);
+        for (const auto* comment : {&parsed, &copy})
+        {
+            CHECK_BRIEF_EQUIVALENT_TO(*comment, R"(
+                <brief-section>A brief.</brief-section>
+                )");
+            CHECK_SECTIONS_EQUIVALENT_TO(*comment, R"(
+                <inline-section name="Return values">A return value.</inline-section>
+                )");
+        }
+    }
+
+    SECTION("Metadata is Parsed Right Away")
+    {
+        const auto parsed = parse(parsers, unindent(R"(
+            A brief.
+            \exclude
+            )"), true);
+
+        REQUIRE(parsed.comment.has_value());
+        CHECK(parsed.comment.value().metadata().exclude() == standardese::comment::exclude_mode::entity);
+        CHECK(!parsed.comment.value().is_deferred());
+        CHECK_BRIEF_EQUIVALENT_TO(parsed, R"(
+            <brief-section>A brief.</brief-section>
+            )");
+    }
+
+    SECTION("Errors are Thrown when the Sections are Accessed")
+    {
+        const auto parsed = parse(parsers, unindent(R"(
+            \brief A brief.
+
+            Details.
+
+            \brief Another brief.
+            )"), true);
+
+        REQUIRE(parsed.comment.has_value());
+        CHECK_THROWS_AS(parsed.comment.value().brief_section(), parse_error);
+        // the sections are not remembered, so every access reports the error
+        CHECK_THROWS_AS(parsed.comment.value().sections(), parse_error);
+    }
+
+    SECTION("Sections do not Keep an Arena Alive")
+    {
+        const auto parsed = parse(parsers, "A brief.", true);
+        REQUIRE(parsed.comment.has_value());
+        REQUIRE(parsed.comment.value().is_deferred());
+
+        {
+            standardese::markup::arena_scope arena;
+            const auto                        allocated = arena.allocated();
+            CHECK(parsed.comment.value().brief_section().has_value());
+            // the sections belong to the comment, not to the document generated in the arena
+            CHECK(arena.allocated() == allocated);
+        }
+
+        CHECK_BRIEF_EQUIVALENT_TO(parsed, R"(
+            <brief-section>A brief.</brief-section>
+            )");
+    }
+}
+
 }
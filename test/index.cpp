@@ -4,6 +4,8 @@
 
 #include <standardese/index.hpp>
 
+#include <thread>
+
 #include "../external/catch/single_include/catch2/catch.hpp"
 
 #include <cppast/cpp_namespace.hpp>
@@ -184,6 +186,34 @@ using z = int;
     }
 }
 
+TEST_CASE("entity_index duplicates")
+{
+    auto file = parse_file({}, "entity_index_duplicates.cpp", R"(
+using a = int;
+)");
+    auto& a = *file->begin();
+
+    auto brief_doc = markup::brief_section::builder()
+                         .add_child(markup::text::build("some brief documentation"))
+                         .finish();
+
+    entity_index index;
+    index.register_entity("first", a, nullptr);
+    // the later registrations are made by other threads, so they might end up in other buckets
+    for (auto i = 0; i != 4; ++i)
+        std::thread([&] { index.register_entity("later", a, type_safe::ref(*brief_doc)); }).join();
+
+    // the first registration wins
+    auto xml = R"(<entity-index id="entity-index">
+<heading>Project index</heading>
+<entity-index-item id="first">
+<entity><documentation-link unresolved-destination-id="first"><code>a</code></documentation-link></entity>
+</entity-index-item>
+</entity-index>
+)";
+    REQUIRE(markup::as_xml(*index.generate(entity_index::order::namespace_inline_sorted)) == xml);
+}
+
 TEST_CASE("file_index")
 {
     auto brief_doc = markup::brief_section::builder()
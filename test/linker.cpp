@@ -6,7 +6,12 @@
 
 #include "../external/catch/single_include/catch2/catch.hpp"
 
+#include <standardese/markup/doc_section.hpp>
 #include <standardese/markup/document.hpp>
+#include <standardese/markup/documentation.hpp>
+#include <standardese/markup/heading.hpp>
+#include <standardese/markup/paragraph.hpp>
+#include <standardese/markup/phrasing.hpp>
 
 #include "test_parser.hpp"
 
@@ -69,6 +74,236 @@ TEST_CASE("linker")
         REQUIRE(equal_destination(l.lookup_documentation(nullptr, "foo"), *document_b,
                                   markup::block_id("foo")));
     }
+    SECTION("freezing")
+    {
+        REQUIRE(l.register_documentation("foo()", *document_a, markup::block_id("foo"), false));
+        REQUIRE(l.register_documentation("bar", *document_b, markup::block_id("bar"), false));
+
+        l.freeze();
+        REQUIRE(l.is_frozen());
+
+        linker::scope_chain scopes(nullptr);
+        REQUIRE(equal_destination(l.lookup_documentation(scopes, "foo"), *document_a,
+                                  markup::block_id("foo")));
+        REQUIRE(equal_destination(l.lookup_documentation(scopes, "bar"), *document_b,
+                                  markup::block_id("bar")));
+        REQUIRE(!l.lookup_documentation(scopes, "baz"));
+        REQUIRE(scopes.cache_misses() == 3u);
+        REQUIRE(scopes.cache_hits() == 0u);
+
+        // the same lookups are remembered, also if they failed
+        REQUIRE(equal_destination(l.lookup_documentation(scopes, "foo()"), *document_a,
+                                  markup::block_id("foo")));
+        REQUIRE(!l.lookup_documentation(scopes, "baz"));
+        REQUIRE(scopes.cache_misses() == 3u);
+        REQUIRE(scopes.cache_hits() == 2u);
+
+        // later chains reuse the results of merged ones
+        l.merge_results(scopes);
+        REQUIRE(l.cache_misses() == 3u);
+        REQUIRE(l.cache_hits() == 2u);
+        REQUIRE(scopes.cache_misses() == 0u);
+
+        linker::scope_chain other(nullptr);
+        REQUIRE(equal_destination(l.lookup_documentation(other, "bar"), *document_b,
+                                  markup::block_id("bar")));
+        REQUIRE(!l.lookup_documentation(other, "baz"));
+        REQUIRE(other.cache_misses() == 0u);
+        REQUIRE(other.cache_hits() == 2u);
+
+        REQUIRE_THROWS_AS(l.register_documentation("baz", *document_a, markup::block_id("baz")),
+                          std::logic_error);
+    }
+    SECTION("relative name lookup with a scope chain")
+    {
+        auto file = parse_file({}, "linker__scope_chain.cpp", R"(
+void func();
+
+namespace ns
+{
+    void func();
+
+    struct type
+    {
+        void func();
+
+        void context1();
+    };
+
+    void context2();
+}
+
+void context3();
+)");
+        REQUIRE(l.register_documentation("func()", *document_a, markup::block_id("func"), false));
+        REQUIRE(l.register_documentation("ns::func()", *document_a, markup::block_id("ns::func"),
+                                         false));
+        REQUIRE(l.register_documentation("ns::type::func()", *document_a,
+                                         markup::block_id("ns::type::func"), false));
+
+        // the innermost scope wins
+        linker::scope_chain scopes(type_safe::ref(get_named_entity(*file, "context1")));
+        REQUIRE(equal_destination(l.lookup_documentation(scopes, "*func"), *document_a,
+                                  markup::block_id("ns::type::func")));
+        REQUIRE(equal_destination(l.lookup_documentation(scopes, "?func()"), *document_a,
+                                  markup::block_id("ns::type::func")));
+        // absolute names ignore the scopes
+        REQUIRE(equal_destination(l.lookup_documentation(scopes, "func"), *document_a,
+                                  markup::block_id("func")));
+
+        scopes.set_context(type_safe::ref(get_named_entity(*file, "context2")));
+        REQUIRE(equal_destination(l.lookup_documentation(scopes, "*func"), *document_a,
+                                  markup::block_id("ns::func")));
+
+        scopes.set_context(type_safe::ref(get_named_entity(*file, "context3")));
+        REQUIRE(equal_destination(l.lookup_documentation(scopes, "*func"), *document_a,
+                                  markup::block_id("func")));
+
+        // without a context, relative names cannot be resolved
+        scopes.set_context(nullptr);
+        REQUIRE(!l.lookup_documentation(scopes, "*func"));
+        REQUIRE(equal_destination(l.lookup_documentation(scopes, "func"), *document_a,
+                                  markup::block_id("func")));
+    }
+    SECTION("remembering relative lookups")
+    {
+        auto file = parse_file({}, "linker__remembering_relative_lookups.cpp", R"(
+void func();
+
+namespace ns
+{
+    void func();
+
+    void context1();
+    void context2();
+}
+
+void context3();
+)");
+        REQUIRE(l.register_documentation("func()", *document_a, markup::block_id("func"), false));
+        REQUIRE(l.register_documentation("ns::func()", *document_a, markup::block_id("ns::func"),
+                                         false));
+        l.freeze();
+
+        auto& context1 = get_named_entity(*file, "context1");
+        auto& context3 = get_named_entity(*file, "context3");
+
+        linker::scope_chain scopes(type_safe::ref(context1));
+        REQUIRE(equal_destination(l.lookup_documentation(scopes, "*func"), *document_a,
+                                  markup::block_id("ns::func")));
+        REQUIRE(scopes.cache_misses() == 1u);
+
+        // a context in the same scope uses the same results
+        scopes.set_context(type_safe::ref(get_named_entity(*file, "context2")));
+        REQUIRE(equal_destination(l.lookup_documentation(scopes, "*func"), *document_a,
+                                  markup::block_id("ns::func")));
+        REQUIRE(scopes.cache_hits() == 1u);
+
+        // a different scope has its own results
+        scopes.set_context(type_safe::ref(context3));
+        REQUIRE(equal_destination(l.lookup_documentation(scopes, "*func"), *document_a,
+                                  markup::block_id("func")));
+        REQUIRE(scopes.cache_misses() == 2u);
+
+        // which are kept when returning to an earlier scope
+        scopes.set_context(type_safe::ref(context1));
+        REQUIRE(equal_destination(l.lookup_documentation(scopes, "*func"), *document_a,
+                                  markup::block_id("ns::func")));
+        scopes.set_context(type_safe::ref(context3));
+        REQUIRE(equal_destination(l.lookup_documentation(scopes, "*func"), *document_a,
+                                  markup::block_id("func")));
+        REQUIRE(scopes.cache_misses() == 2u);
+        REQUIRE(scopes.cache_hits() == 3u);
+    }
+    SECTION("target entities")
+    {
+        cppast::cpp_entity_index index;
+        comment_registry         comments;
+        auto file = build_doc_entities(comments, index, "linker__target_entities.cpp", R"(
+/// Documented.
+void func();
+
+/// Documented.
+void other();
+
+void undocumented();
+)");
+        auto& func         = get_named_entity(*file, "func");
+        auto& other        = get_named_entity(*file, "other");
+        auto& undocumented = get_named_entity(*file, "undocumented");
+        for (auto entity : {&func, &other})
+            REQUIRE(l.register_documentation(entity->link_name(), *document_a,
+                                             entity->get_documentation_id(), false));
+        for (auto entity : {&func, &other, &undocumented})
+            l.register_entity(*entity);
+
+        // before freezing, the link name is looked up
+        REQUIRE(equal_destination(l.lookup_documentation(func), *document_a,
+                                  func.get_documentation_id()));
+
+        auto make_link = [](const char* dest, const doc_entity& target) {
+            return markup::documentation_link::builder(dest, target)
+                .add_child(markup::text::build(dest))
+                .finish();
+        };
+        // the destination is not registered, the target is
+        auto by_target = make_link("unregistered", other);
+        // the relative name depends on the context, so it is looked up instead of the target
+        auto relative = make_link("*func", other);
+        // the target has no documentation
+        auto no_documentation = make_link("undocumented", undocumented);
+
+        auto& by_target_ref        = *by_target;
+        auto& relative_ref         = *relative;
+        auto& no_documentation_ref = *no_documentation;
+
+        markup::file_documentation::builder documentation(type_safe::ref(file->file()),
+                                                          markup::block_id("file"),
+                                                          markup::heading::build(markup::block_id(),
+                                                                                 "A file"),
+                                                          nullptr);
+        documentation.add_details(markup::details_section::builder()
+                                      .add_child(markup::paragraph::builder()
+                                                     .add_child(std::move(by_target))
+                                                     .add_child(std::move(relative))
+                                                     .add_child(std::move(no_documentation))
+                                                     .finish())
+                                      .finish());
+        auto doc = markup::main_document::builder("doc", "doc")
+                       .add_child(documentation.finish())
+                       .finish();
+
+        l.freeze();
+        REQUIRE(equal_destination(l.lookup_documentation(other), *document_a,
+                                  other.get_documentation_id()));
+        REQUIRE(!l.lookup_documentation(undocumented));
+
+        class counting_logger : public cppast::diagnostic_logger
+        {
+        public:
+            mutable unsigned count = 0;
+
+        private:
+            bool do_log(const char*, const cppast::diagnostic&) const override
+            {
+                ++count;
+                return true;
+            }
+        } logger;
+        resolve_links(logger, l, *doc);
+
+        REQUIRE(by_target_ref.internal_destination());
+        REQUIRE(by_target_ref.internal_destination().value().id()
+                == other.get_documentation_id());
+
+        REQUIRE(relative_ref.internal_destination());
+        REQUIRE(relative_ref.internal_destination().value().id() == func.get_documentation_id());
+
+        REQUIRE(!no_documentation_ref.internal_destination());
+        REQUIRE(!no_documentation_ref.external_destination());
+        REQUIRE(no_documentation_ref.unresolved_destination());
+        REQUIRE(logger.count == 1u);
+    }
     SECTION("short and long link names")
     {
         REQUIRE(l.register_documentation("foo()", *document_a, markup::block_id("foo"), false));
@@ -0,0 +1,68 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include <standardese/markup/arena.hpp>
+
+#include "../external/catch/single_include/catch2/catch.hpp"
+
+#include <standardese/markup/generator.hpp>
+#include <standardese/markup/paragraph.hpp>
+#include <standardese/markup/phrasing.hpp>
+
+using namespace standardese::markup;
+
+namespace
+{
+std::unique_ptr<paragraph> build_paragraph()
+{
+    paragraph::builder builder(block_id("foo"));
+    builder.add_child(text::build("a"));
+    builder.add_child(emphasis::build("b"));
+    builder.add_child(
+        code::builder().add_child(emphasis::build("c")).add_child(text::build("d")).finish());
+    return builder.finish();
+}
+} // namespace
+
+TEST_CASE("arena_scope", "[markup]")
+{
+    auto expected = as_xml(*build_paragraph());
+
+    std::unique_ptr<paragraph> ptr;
+    {
+        arena_scope arena;
+        REQUIRE(arena.allocated() == 0u);
+
+        ptr = build_paragraph();
+        REQUIRE(arena.allocated() > 0u);
+
+        SECTION("nested")
+        {
+            arena_scope nested;
+            auto        copy = clone(*ptr);
+            REQUIRE(nested.allocated() > 0u);
+            REQUIRE(as_xml(*copy) == expected);
+        }
+        SECTION("heap")
+        {
+            auto allocated = arena.allocated();
+
+            std::unique_ptr<paragraph> copy;
+            {
+                heap_scope heap;
+                copy = clone(*ptr);
+            }
+            REQUIRE(arena.allocated() == allocated);
+            REQUIRE(as_xml(*copy) == expected);
+
+            // the arena is used again afterwards
+            clone(*ptr);
+            REQUIRE(arena.allocated() > allocated);
+        }
+    }
+
+    // the entities keep the arena alive
+    REQUIRE(as_xml(*ptr) == expected);
+    REQUIRE(as_xml(*ptr->clone()) == expected);
+}
@@ -6,6 +6,7 @@
 
 #include "../external/catch/single_include/catch2/catch.hpp"
 
+#include <standardese/markup/entity_kind.hpp>
 #include <standardese/markup/generator.hpp>
 
 using namespace standardese::markup;
@@ -96,3 +97,76 @@ void foo();
 ```
 )");
 }
+
+TEST_CASE("code-block::compact_builder", "[markup]")
+{
+    auto html =
+        R"(<pre><code id="standardese-foo" class="standardese-language-cpp"><span class="kwd">template</span> <span class="pun">&lt;</span><span class="kwd">typename</span> <span class="typ dec var fun">T</span><span class="pun">&gt;</span>
+<span class="kwd">void</span> <span class="typ dec var fun">foo</span><span class="pun">();</span>
+</code></pre>
+)";
+
+    auto xml =
+        R"(<code-block id="foo" language="cpp"><code-block-keyword>template</code-block-keyword> <code-block-punctuation>&lt;</code-block-punctuation><code-block-keyword>typename</code-block-keyword> <code-block-identifier>T</code-block-identifier><code-block-punctuation>&gt;</code-block-punctuation>
+<code-block-keyword>void</code-block-keyword> <code-block-identifier>foo</code-block-identifier><code-block-punctuation>();</code-block-punctuation>
+</code-block>
+)";
+
+    code_block::compact_builder builder(block_id("foo"), "cpp");
+    builder.add_token(code_block::token_kind::keyword, "template");
+    builder.add_token(code_block::token_kind::text, " ");
+    builder.add_token(code_block::token_kind::punctuation, "<");
+    builder.add_token(code_block::token_kind::keyword, "typename");
+    builder.add_token(code_block::token_kind::text, " ");
+    builder.add_token(code_block::token_kind::identifier, "T");
+    builder.add_token(code_block::token_kind::punctuation, ">");
+    builder.add_token(code_block::token_kind::text, "\n");
+    builder.add_token(code_block::token_kind::keyword, "void");
+    builder.add_token(code_block::token_kind::text, " ");
+    builder.add_token(code_block::token_kind::identifier, "foo");
+    builder.add_token(code_block::token_kind::punctuation, "();");
+    builder.add_token(code_block::token_kind::text, "\n");
+
+    auto ptr = builder.finish();
+    REQUIRE(ptr->is_compact());
+    REQUIRE(ptr->code() == "template <typename T>\nvoid foo();\n");
+    REQUIRE(ptr->tokens().size() == 13u);
+
+    REQUIRE(as_html(*ptr) == html);
+    REQUIRE(as_xml(*ptr->clone()) == xml);
+    REQUIRE(render(markdown_generator(false, "", "md"), *ptr) == R"(``` cpp
+template <typename T>
+void foo();
+```
+)");
+
+    SECTION("tokens")
+    {
+        code_block::compact_builder b(block_id("bar"), "cpp");
+        b.add_indent(4u);
+        b.add_token(code_block::token_kind::text, "a");
+        b.add_soft_break();
+        b.add_link(documentation_link::builder("b"), "b", 1u);
+        b.add_token(code_block::token_kind::punctuation, "");
+
+        auto block = b.finish();
+        REQUIRE(block->code() == "    a\nb");
+
+        auto& tokens = block->tokens();
+        REQUIRE(tokens.size() == 3u);
+        REQUIRE(tokens[0].kind() == code_block::token_kind::text);
+        REQUIRE(tokens[0].length() == 5u);
+        REQUIRE(tokens[1].kind() == code_block::token_kind::soft_break);
+        REQUIRE(tokens[2].kind() == code_block::token_kind::link);
+        REQUIRE(tokens[2].offset() == 6u);
+        REQUIRE(block->link(tokens[2]).unresolved_destination().value() == "b");
+        REQUIRE(&block->link(tokens[2]).parent().value() == block.get());
+
+        // the view contains one entity per token, the link entity is shared
+        auto iter = block->begin();
+        REQUIRE(iter->kind() == entity_kind::text);
+        REQUIRE((++iter)->kind() == entity_kind::soft_break);
+        REQUIRE(&*++iter == &block->link(tokens[2]));
+        REQUIRE(++iter == block->end());
+    }
+}
@@ -38,6 +38,11 @@ TEST_CASE("external_link", "[markup]")
     REQUIRE(as_markdown(*b_ptr)
             == "[with title](foo/bar/\\<%20&\\> \"title\\\"\")\n"); // MSVC doesn't like a raw
                                                                     // string here :(
+
+    external_link::builder c(url("http://foonathan.net/a-long-path/with_some/fil\xC3\xA9s/[x]/"));
+    c.add_child(text::build("long"));
+    REQUIRE(as_html(*c.finish())
+            == "<a href=\"http://foonathan.net/a-long-path/with_some/fil%C3%A9s/%5Bx%5D/\">long</a>");
 }
 
 TEST_CASE("documentation_link", "[markup]")
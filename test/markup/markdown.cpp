@@ -0,0 +1,273 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include <standardese/markup/generator.hpp>
+
+#include "../external/catch/single_include/catch2/catch.hpp"
+
+#include <algorithm>
+
+#include <cppast/cpp_file.hpp>
+#include <standardese/markup/code_block.hpp>
+#include <standardese/markup/doc_section.hpp>
+#include <standardese/markup/document.hpp>
+#include <standardese/markup/documentation.hpp>
+#include <standardese/markup/heading.hpp>
+#include <standardese/markup/link.hpp>
+#include <standardese/markup/list.hpp>
+#include <standardese/markup/paragraph.hpp>
+#include <standardese/markup/quote.hpp>
+
+using namespace standardese::markup;
+
+// The expected output is the one of the cmark renderers for the equivalent cmark document.
+
+namespace
+{
+std::string as_commonmark(const entity& e)
+{
+    return render(markdown_generator(false, "", "md"), e);
+}
+
+// '$' marks trailing spaces
+std::string spaces(std::string str)
+{
+    std::replace(str.begin(), str.end(), '$', ' ');
+    return str;
+}
+
+std::unique_ptr<paragraph> make_paragraph(const char* str)
+{
+    return paragraph::builder().add_child(text::build(str)).finish();
+}
+
+std::unique_ptr<list_item> make_item(const char* str)
+{
+    return list_item::build(make_paragraph(str));
+}
+
+std::unique_ptr<main_document> make_document(std::vector<std::unique_ptr<block_entity>> blocks)
+{
+    main_document::builder builder("Markdown", "markdown");
+    for (auto& block : blocks)
+        builder.add_child(std::move(block));
+    return builder.finish();
+}
+
+template <typename... Blocks>
+std::unique_ptr<main_document> make_document(Blocks... blocks)
+{
+    std::vector<std::unique_ptr<block_entity>> vec;
+    (vec.push_back(std::move(blocks)), ...);
+    return make_document(std::move(vec));
+}
+} // namespace
+
+TEST_CASE("markdown nested lists", "[markup]")
+{
+    auto inner = unordered_list::builder(block_id());
+    inner.add_item(make_item("b"));
+    inner.add_item(make_item("c"));
+
+    auto outer = unordered_list::builder(block_id());
+    outer.add_item(
+        list_item::builder().add_child(make_paragraph("a")).add_child(inner.finish()).finish());
+    outer.add_item(make_item("d"));
+    auto ptr = outer.finish();
+
+    auto expected = spaces(R"(  - a
+$$$$
+      - b
+$$$$
+      - c
+
+  - d
+)");
+    REQUIRE(as_commonmark(*ptr) == expected);
+    REQUIRE(as_text(*ptr) == expected);
+}
+
+TEST_CASE("markdown tight lists", "[markup]")
+{
+    auto nested = unordered_list::builder(block_id());
+    nested.add_item(make_item("nested"));
+
+    auto list = unordered_list::builder(block_id());
+    list.add_item(make_item("first"));
+    list.add_item(list_item::builder()
+                      .add_child(make_paragraph("second"))
+                      .add_child(nested.finish())
+                      .finish());
+    list.add_item(make_item("third"));
+
+    cppast::cpp_file::builder file("foo");
+    file_documentation::builder builder(type_safe::ref(file.get()), block_id("file"),
+                                        heading::build(block_id(), "A file"), nullptr);
+    builder.add_section(list_section::build("List", list.finish()));
+    auto ptr = builder.finish();
+
+    REQUIRE(as_commonmark(*ptr) == R"(# A file
+
+#### List
+
+  - first
+  - second
+      - nested
+  - third
+)");
+    REQUIRE(as_text(*ptr) == R"(A file
+
+List
+
+  - first
+  - second
+      - nested
+  - third
+)");
+}
+
+TEST_CASE("markdown blocks after lists", "[markup]")
+{
+    auto make_list = [](const char* str) {
+        return unordered_list::builder(block_id()).add_item(make_item(str)).finish();
+    };
+    auto ptr = make_document(make_list("a"), code_block::build(block_id(), "", "code();"),
+                             make_list("b"), make_list("c"));
+
+    REQUIRE(as_commonmark(*ptr) == R"(  - a
+
+<!-- end list -->
+
+    code();
+
+  - b
+
+<!-- end list -->
+
+  - c
+)");
+    REQUIRE(as_text(*ptr) == R"(  - a
+
+code();
+
+  - b
+
+  - c
+)");
+}
+
+TEST_CASE("markdown code block in list item", "[markup]")
+{
+    auto list = unordered_list::builder(block_id());
+    list.add_item(list_item::builder()
+                      .add_child(code_block::build(block_id(), "", "a ``` b"))
+                      .add_child(make_paragraph("x"))
+                      .finish());
+    auto ptr = list.finish();
+
+    REQUIRE(as_commonmark(*ptr) == spaces(R"(  - ````$
+    a ``` b
+    ````
+$$$$
+    x
+)"));
+    REQUIRE(as_text(*ptr) == spaces(R"(  - a ``` b
+$$$$
+    x
+)"));
+}
+
+TEST_CASE("markdown block quote with list", "[markup]")
+{
+    auto list = unordered_list::builder(block_id());
+    list.add_item(make_item("a"));
+    list.add_item(list_item::builder().finish());
+
+    auto quote = block_quote::builder(block_id());
+    quote.add_child(list.finish());
+    auto ptr = make_document(quote.finish(), make_paragraph("after"));
+
+    REQUIRE(as_commonmark(*ptr) == spaces(R"(>   - a
+>$
+>   -$
+
+after
+)"));
+    // the plain text renderer ignores block quotes, so there is no blank line
+    REQUIRE(as_text(*ptr) == spaces(R"(  - a
+
+  -$
+after
+)"));
+}
+
+TEST_CASE("markdown long ordered list", "[markup]")
+{
+    auto list = ordered_list::builder(block_id());
+    for (auto i = 0; i != 11; ++i)
+        list.add_item(make_item("x"));
+    auto ptr = list.finish();
+
+    auto expected = R"(1.  x
+
+2.  x
+
+3.  x
+
+4.  x
+
+5.  x
+
+6.  x
+
+7.  x
+
+8.  x
+
+9.  x
+
+10. x
+
+11. x
+)";
+    REQUIRE(as_commonmark(*ptr) == expected);
+    REQUIRE(as_text(*ptr) == expected);
+}
+
+TEST_CASE("markdown autolinks", "[markup]")
+{
+    auto ptr = paragraph::builder()
+                   .add_child(text::build("see "))
+                   .add_child(external_link::builder(url("http://x.org"))
+                                  .add_child(text::build("http://x.org"))
+                                  .finish())
+                   .add_child(text::build(" and "))
+                   .add_child(external_link::builder(url("mailto:a@b.org"))
+                                  .add_child(text::build("a@b.org"))
+                                  .finish())
+                   .add_child(text::build(" or "))
+                   .add_child(external_link::builder(url("http://y.org"))
+                                  .add_child(text::build("y"))
+                                  .finish())
+                   .finish();
+
+    REQUIRE(as_commonmark(*ptr) == "see <http://x.org> and <a@b.org> or [y](http://y.org)\n");
+    REQUIRE(as_text(*ptr) == "see http://x.org and a@b.org or y\n");
+}
+
+TEST_CASE("markdown tabs and control characters", "[markup]")
+{
+    auto ptr = paragraph::builder()
+                   .add_child(text::build("a\tb\x01"
+                                          "c "))
+                   .add_child(external_link::builder(url("a\tb"))
+                                  .add_child(text::build("\td"))
+                                  .finish())
+                   .finish();
+
+    REQUIRE(as_commonmark(*ptr) == "a\tb\x01"
+                                   "c [\td](a%09b)\n");
+    REQUIRE(as_text(*ptr) == "a\tb\x01"
+                             "c \td\n");
+}
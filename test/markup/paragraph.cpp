@@ -30,3 +30,18 @@ TEST_CASE("paragraph", "[markup]")
     REQUIRE(as_xml(*ptr) == xml);
     REQUIRE(as_markdown(*ptr) == md);
 }
+
+TEST_CASE("paragraph long", "[markup]")
+{
+    // bigger than the buffer of the HTML generator
+    std::string html = "<p>";
+    paragraph::builder builder((block_id()));
+    for (auto i = 0; i != 10000; ++i)
+    {
+        builder.add_child(emphasis::build("a&b"));
+        html += "<em>a&amp;b</em>";
+    }
+    html += "</p>\n";
+
+    REQUIRE(as_html(*builder.finish()) == html);
+}
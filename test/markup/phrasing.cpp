@@ -27,6 +27,29 @@ TEST_CASE("text", "[markup]")
     REQUIRE(as_xml(*c) == "&lt;html&gt;&amp;&quot;&apos;&lt;/html&gt;");
     REQUIRE(as_markdown(*c) == R"(\<html\>&"'\</html\>
 )");
+
+    // list markers at the beginning of a line
+    REQUIRE(as_markdown(*text::build("- a - b")) == "\\- a - b\n");
+    REQUIRE(as_markdown(*text::build("10. a")) == "10\\. a\n");
+    REQUIRE(as_markdown(*text::build("a&b & c")) == "a\\&b & c\n");
+    REQUIRE(as_text(*text::build("<*a*>")) == "<*a*>\n");
+}
+
+TEST_CASE("text escaping", "[markup]")
+{
+    // special characters at every position of a longer text
+    for (auto pos = 0u; pos != 70u; ++pos)
+    {
+        std::string str(70u, 'a');
+        str[pos] = '<';
+        str += "&&'/";
+
+        std::string expected(70u, 'a');
+        expected.replace(pos, 1u, "&lt;");
+        expected += "&amp;&amp;&#x27;&#x2F;";
+
+        REQUIRE(as_html(*text::build(str)) == expected);
+    }
 }
 
 template <typename T>
@@ -67,6 +90,9 @@ void test_phrasing(const std::string& html, const std::string& xml, const std::s
 TEST_CASE("emphasis", "[markup]")
 {
     test_phrasing<emphasis>("em", "emphasis", "*");
+
+    auto nested = emphasis::builder().add_child(emphasis::build("foo")).finish();
+    REQUIRE(as_markdown(*nested) == "*_foo_*\n");
 }
 
 TEST_CASE("strong_emphasis", "[markup]")
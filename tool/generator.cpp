@@ -4,46 +4,145 @@
 
 #include "generator.hpp"
 
+#include <algorithm>
 #include <fstream>
 
+#include <cppast/visitor.hpp>
+
 #include <standardese/index.hpp>
 #include <standardese/linker.hpp>
+#include <standardese/markup/arena.hpp>
 
-#include "thread_pool.hpp"
+#include "trace.hpp"
 
 using namespace standardese_tool;
 
+void parse_times::read(const fs::path& path)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // each line is the time in microseconds followed by the path of the file
+    std::ifstream in(path.string());
+    std::uint64_t time;
+    std::string   file;
+    while (in >> time && in.get() == ' ' && std::getline(in, file))
+        times_[file] = time;
+}
+
+void parse_times::write(const fs::path& path) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    boost::system::error_code ec;
+    if (path.has_parent_path())
+        fs::create_directories(path.parent_path(), ec);
+
+    std::ofstream out(path.string());
+    for (auto& entry : times_)
+        out << entry.second << ' ' << entry.first << '\n';
+}
+
+void parse_times::record(const input_file& file, std::chrono::microseconds time)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    times_[file.path.generic_string()] = std::uint64_t(time.count());
+}
+
+std::vector<std::size_t> parse_times::schedule(const std::vector<input_file>& files) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::vector<type_safe::optional<std::uint64_t>> times;
+    std::vector<std::uint64_t>                      sizes;
+    // to convert the size of files without a recorded time into a time
+    std::uint64_t total_time = 0u, total_size = 0u;
+    for (auto& file : files)
+    {
+        boost::system::error_code ec;
+        auto                      size = fs::file_size(file.path, ec);
+        sizes.push_back(ec ? 0u : std::uint64_t(size));
+
+        auto iter = times_.find(file.path.generic_string());
+        if (iter != times_.end())
+        {
+            times.push_back(iter->second);
+            total_time += iter->second;
+            total_size += sizes.back();
+        }
+        else
+            times.push_back(type_safe::nullopt);
+    }
+
+    std::vector<double> costs;
+    for (auto i = 0u; i != files.size(); ++i)
+        if (times[i])
+            costs.push_back(double(times[i].value()));
+        else if (total_size == 0u)
+            // nothing recorded, so only the sizes matter
+            costs.push_back(double(sizes[i]));
+        else
+            costs.push_back(double(sizes[i]) * double(total_time) / double(total_size));
+
+    std::vector<std::size_t> order(files.size());
+    for (auto i = 0u; i != order.size(); ++i)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(),
+                     [&](std::size_t lhs, std::size_t rhs) { return costs[lhs] > costs[rhs]; });
+    return order;
+}
+
 type_safe::optional<std::vector<parsed_file>> standardese_tool::parse(
     const cppast::libclang_compile_config&                            config,
     const type_safe::optional<cppast::libclang_compilation_database>& database,
     const std::vector<input_file>& files, const cppast::cpp_entity_index& index,
-    unsigned no_threads)
+    thread_pool& pool, parse_times& times, profiler& prof,
+    const std::function<void(const cppast::cpp_file&)>& on_parsed)
 {
-    std::vector<parsed_file> result;
+    auto stage = prof.time_stage("parse");
+
+    // one slot per file, so the order does not depend on scheduling
+    std::vector<parsed_file> result(files.size());
     bool                     error(false);
     cppast::libclang_parser  parser(cppast::default_logger());
 
     {
-        std::mutex  mutex;
-        thread_pool pool(no_threads);
-        for (auto& file : files)
+        std::mutex mutex;
+        task_group jobs(pool);
+        // a single expensive file started last would dominate the total time
+        for (auto i : times.schedule(files))
         {
-            add_job(pool, [&, file] {
+            jobs.run([&, i] {
+                auto&       file = files[i];
+                auto        path = file.path.generic_string();
+                trace_scope trace("parse", path.c_str());
+
                 auto db_config = database.map([&](const cppast::libclang_compilation_database& db) {
                     return cppast::find_config_for(db, file.path.generic_string());
                 });
 
                 auto actual_config = db_config.value_or(config);
+                auto start         = std::chrono::steady_clock::now();
                 auto parsed
                     = parser.parse(index, fs::canonical(file.path).generic_string(), actual_config);
 
-                std::lock_guard<std::mutex> lock(mutex);
                 if (parsed)
-                    result.push_back({std::move(parsed), file.relative.generic_string()});
+                {
+                    auto time = std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - start);
+                    times.record(file, time);
+                    prof.record_parse(parsed->name(), time);
+                    if (on_parsed)
+                        on_parsed(*parsed);
+                    result[i] = {std::move(parsed), file.relative.generic_string()};
+                }
                 else
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
                     error = true;
+                }
             });
         }
+        jobs.wait();
     }
 
     if (error)
@@ -52,52 +151,101 @@ type_safe::optional<std::vector<parsed_file>> standardese_tool::parse(
         return std::move(result);
 }
 
+void standardese_tool::parse_comments(const standardese::file_comment_parser& parser,
+                                      const cppast::cpp_file& file, profiler& prof)
+{
+    trace_scope trace("parse_comments", file.name().c_str());
+    parser.parse(type_safe::ref(file));
+
+    if (prof.enabled())
+    {
+        auto count = file.unmatched_comments().size();
+        cppast::visit(file,
+                      [&](const cppast::cpp_entity& entity, const cppast::visitor_info& info) {
+                          if (info.event != cppast::visitor_info::container_entity_exit
+                              && entity.comment())
+                              ++count;
+                      });
+        prof.record_comments(file.name(), count);
+    }
+}
+
 standardese::comment_registry standardese_tool::parse_comments(
     const standardese::comment::config& config, const std::vector<parsed_file>& files,
-    unsigned no_threads)
+    thread_pool& pool, profiler& prof)
 {
+    auto stage = prof.time_stage("parse_comments");
+
     standardese::file_comment_parser parser(cppast::default_logger(), config);
     {
-        thread_pool pool(no_threads);
+        task_group jobs(pool);
         for (auto& file : files)
-            add_job(pool, [&file, &parser] { parser.parse(type_safe::ref(*file.file)); });
+            jobs.run([&file, &parser, &prof] { parse_comments(parser, *file.file, prof); });
+        jobs.wait();
     }
+    prof.record_cache("comments", parser.parse_cache().hits(), parser.parse_cache().misses());
     return parser.finish();
 }
 
 std::vector<std::unique_ptr<standardese::doc_cpp_file>> standardese_tool::build_files(
     const standardese::comment_registry& registry, const cppast::cpp_entity_index& index,
     std::vector<parsed_file>&& files, const standardese::entity_blacklist& blacklist,
-    bool hide_uncommented, unsigned no_threads)
+    bool hide_uncommented, thread_pool& pool, profiler& prof)
 {
+    task_group jobs(pool);
     {
-        thread_pool pool(no_threads);
+        auto stage = prof.time_stage("exclude");
         for (auto& file : files)
-            add_job(pool,
-                    [&] { standardese::exclude_entities(registry, index, blacklist, hide_uncommented, *file.file); });
+            jobs.run([&] {
+                trace_scope trace("exclude", file.file->name().c_str());
+                standardese::exclude_entities(registry, index, blacklist, hide_uncommented,
+                                              *file.file);
+            });
+        // the entities of one file can refer to excluded entities of any other file
+        jobs.wait();
     }
 
-    std::vector<std::unique_ptr<standardese::doc_cpp_file>> result;
-
-    {
-        std::mutex  mutex;
-        thread_pool pool(no_threads);
-        for (auto& file : files)
-            add_job(pool, [&] {
-                auto entity = standardese::build_doc_entities(type_safe::ref(registry), index,
-                                                              std::move(file.file),
-                                                              std::move(file.output_name));
+    auto stage = prof.time_stage("build_files");
 
-                std::lock_guard<std::mutex> lock(mutex);
-                result.push_back(std::move(entity));
-            });
-    }
+    std::vector<std::unique_ptr<standardese::doc_cpp_file>> result(files.size());
+    for (auto i = 0u; i != files.size(); ++i)
+        jobs.run([&, i] {
+            trace_scope trace("build", files[i].file->name().c_str());
+            result[i] = standardese::build_doc_entities(type_safe::ref(registry), index,
+                                                        std::move(files[i].file),
+                                                        std::move(files[i].output_name));
+        });
+    jobs.wait();
 
     return result;
 }
 
 namespace
 {
+// collects the diagnostics so that they can be logged later in a fixed order
+class buffered_logger : public cppast::diagnostic_logger
+{
+public:
+    // buffers everything, the final logger decides what is verbose
+    buffered_logger() : cppast::diagnostic_logger(true) {}
+
+    void flush(const cppast::diagnostic_logger& logger)
+    {
+        for (auto& d : diagnostics_)
+            logger.log(d.first.c_str(), d.second);
+        diagnostics_.clear();
+    }
+
+private:
+    bool do_log(const char* source, const cppast::diagnostic& d) const override
+    {
+        diagnostics_.emplace_back(source, d);
+        return true;
+    }
+
+    mutable std::vector<std::pair<std::string, cppast::diagnostic>> diagnostics_;
+};
+
 std::unique_ptr<standardese::markup::document_entity> get_index_document(
     std::unique_ptr<standardese::markup::index_entity> index, const char* title, const char* name)
 {
@@ -110,72 +258,117 @@ std::unique_ptr<standardese::markup::document_entity> get_index_document(
 documents standardese_tool::generate(
     const standardese::generation_config& gen_config,
     const standardese::synopsis_config& syn_config, const standardese::comment_registry& comments,
-    const cppast::cpp_entity_index& index, const standardese::linker& linker,
-    const std::vector<std::unique_ptr<standardese::doc_cpp_file>>& files, unsigned no_threads)
+    const cppast::cpp_entity_index& index, standardese::linker& linker,
+    const std::vector<std::unique_ptr<standardese::doc_cpp_file>>& files, thread_pool& pool,
+    profiler&                                                                prof,
+    const std::function<void(const standardese::markup::document_entity&)>& on_resolved)
 {
-    std::mutex                                                         result_mutex;
-    std::vector<std::unique_ptr<standardese::markup::document_entity>> result;
+    // one slot per file followed by the three indices, so the documents are in a deterministic
+    // order
+    std::vector<std::unique_ptr<standardese::markup::document_entity>> result(files.size() + 3u);
 
     standardese::entity_index eindex;
     standardese::file_index   findex;
     standardese::module_index mindex;
 
-    {
-        thread_pool pool(no_threads);
+    // one for each document, declared before the group that uses them
+    std::vector<buffered_logger> loggers(result.size());
 
-        std::vector<std::future<void>> futures;
-        for (auto& file : files)
-            futures.push_back(add_job(pool, [&] {
-                standardese::markup::subdocument::builder document(file->output_name(),
-                                                                   "doc_"
-                                                                       + get_output_file_name(
-                                                                             file->output_name()));
-                document.add_child(
-                    standardese::generate_documentation(gen_config, syn_config, index, *file));
-                auto finished_doc = document.finish();
-
-                standardese::register_documentations(*cppast::default_logger(), linker,
-                                                     *finished_doc);
-                standardese::register_index_entities(eindex, file->file());
-                standardese::register_module_entities(mindex, comments, file->file());
-                findex.register_file(file->link_name(), file->output_name(),
-                                     file->comment() ? file->comment().value().brief_section()
-                                                     : nullptr);
-
-                std::lock_guard<std::mutex> lock(result_mutex);
-                result.push_back(std::move(finished_doc));
-            }));
-
-        for (auto& future : futures)
-            future.get(); // to retrieve exceptions
-    }
+    auto generate_stage = type_safe::make_optional(prof.time_stage("generate"));
+
+    task_group jobs(pool);
+    for (auto i = 0u; i != files.size(); ++i)
+        jobs.run([&, i] {
+            auto&       file = files[i];
+            trace_scope trace("generate", file->output_name().c_str());
+            // the document is built by this thread alone and consists of many small entities
+            standardese::markup::arena_scope          arena;
+            standardese::markup::subdocument::builder document(file->output_name(),
+                                                               "doc_"
+                                                                   + get_output_file_name(
+                                                                         file->output_name()));
+            document.add_child(
+                standardese::generate_documentation(gen_config, syn_config, index, *file));
+            auto finished_doc = document.finish();
+
+            standardese::register_documentations(*cppast::default_logger(), linker,
+                                                 *finished_doc);
+            standardese::register_index_entities(eindex, file->file());
+            standardese::register_module_entities(mindex, comments, file->file());
+            findex.register_file(file->link_name(), file->output_name(),
+                                 file->comment() ? file->comment().value().brief_section()
+                                                 : nullptr);
+
+            result[i] = std::move(finished_doc);
+        });
+    jobs.wait();
 
-    auto eindex_doc = get_index_document(eindex.generate(gen_config.order()), "Entities",
-                                         "standardese_entities");
-    standardese::register_documentations(*cppast::default_logger(), linker, *eindex_doc);
-    result.push_back(std::move(eindex_doc));
+    // the indices are complete now, and independent of each other
+    auto add_index_document = [&](std::size_t i, auto generate, const char* title,
+                                  const char* name) {
+        jobs.run([&, i, generate, title, name] {
+            trace_scope                      trace("index", name);
+            standardese::markup::arena_scope arena;
+            result[i] = get_index_document(generate(), title, name);
+            standardese::register_documentations(*cppast::default_logger(), linker, *result[i]);
+        });
+    };
+    add_index_document(files.size(), [&] { return eindex.generate(gen_config.order()); },
+                       "Entities", "standardese_entities");
+    add_index_document(files.size() + 1u, [&] { return findex.generate(); }, "Files",
+                       "standardese_files");
+    add_index_document(files.size() + 2u, [&] { return mindex.generate(); }, "Modules",
+                       "standardese_modules");
+    jobs.wait();
 
-    auto findex_doc = get_index_document(findex.generate(), "Files", "standardese_files");
-    standardese::register_documentations(*cppast::default_logger(), linker, *findex_doc);
-    result.push_back(std::move(findex_doc));
+    // everything is registered, so the lookups do not need to synchronize anymore,
+    // links cannot be resolved any earlier as the indices register the documentation of
+    // namespaces and modules
+    linker.freeze();
+    generate_stage.reset();
 
-    auto mindex_doc = get_index_document(mindex.generate(), "Modules", "standardese_modules");
-    standardese::register_documentations(*cppast::default_logger(), linker, *mindex_doc);
-    result.push_back(std::move(mindex_doc));
+    auto resolve_stage = prof.time_stage("resolve_links");
+    for (auto i = 0u; i != result.size(); ++i)
+        jobs.run([&, i] {
+            trace_scope trace("resolve_links", result[i]->output_name().name().c_str());
+            standardese::resolve_links(loggers[i], linker, *result[i]);
+            if (on_resolved)
+                on_resolved(*result[i]);
+        });
+    jobs.wait();
+    prof.record_cache("links", linker.cache_hits(), linker.cache_misses());
 
-    for (auto& doc : result)
-        standardese::resolve_links(*cppast::default_logger(), linker, *doc);
+    for (auto& logger : loggers)
+        logger.flush(*cppast::default_logger());
 
     return result;
 }
 
+void standardese_tool::write_file(const standardese::markup::document_entity& doc,
+                                  standardese::markup::generator generator,
+                                  const std::string& prefix, const char* extension,
+                                  profiler& prof)
+{
+    auto        path = prefix + doc.output_name().file_name(extension);
+    trace_scope trace("write", path.c_str());
+    auto        start = std::chrono::steady_clock::now();
+
+    std::ofstream file(path);
+    generator(file, doc);
+
+    if (prof.enabled())
+        prof.record_write(extension, std::size_t(std::max(std::streamoff(file.tellp()),
+                                                          std::streamoff(0))),
+                          std::chrono::duration_cast<std::chrono::microseconds>(
+                              std::chrono::steady_clock::now() - start));
+}
+
 void standardese_tool::write_files(const documents& docs, standardese::markup::generator generator,
-                                   std::string prefix, const char* extension, unsigned no_threads)
+                                   std::string prefix, const char* extension, task_group& jobs,
+                                   profiler& prof)
 {
-    thread_pool pool(no_threads);
     for (auto& doc : docs)
-        add_job(pool, [&] {
-            std::ofstream file(prefix + doc->output_name().file_name(extension));
-            generator(file, *doc);
+        jobs.run([&doc, generator, prefix, extension, &prof] {
+            write_file(*doc, generator, prefix, extension, prof);
         });
 }
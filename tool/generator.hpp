@@ -5,6 +5,11 @@
 #ifndef STANDARDESE_TOOL_GENERATOR_HPP_INCLUDED
 #define STANDARDESE_TOOL_GENERATOR_HPP_INCLUDED
 
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 
 #include <cppast/cpp_entity_index.hpp>
@@ -18,6 +23,8 @@
 #include <standardese/markup/generator.hpp>
 
 #include "filesystem.hpp"
+#include "profile.hpp"
+#include "thread_pool.hpp"
 
 namespace standardese_tool
 {
@@ -33,32 +40,71 @@ struct parsed_file
     std::string                       output_name;
 };
 
+// the time it took to parse each file in a previous run,
+// used to start with the files that take the longest
+class parse_times
+{
+public:
+    parse_times() = default;
+
+    // reads the times written by a previous run, if there are any
+    void read(const fs::path& path);
+
+    void write(const fs::path& path) const;
+
+    // thread-safe
+    void record(const input_file& file, std::chrono::microseconds time);
+
+    // returns the files in the order they should be parsed, i.e. the most expensive ones first,
+    // files without a recorded time are estimated from their size
+    std::vector<std::size_t> schedule(const std::vector<input_file>& files) const;
+
+private:
+    mutable std::mutex                              mutex_;
+    std::unordered_map<std::string, std::uint64_t> times_; // in microseconds
+};
+
+// parses the files in the order given by `times` and records the new times there,
+// calls `on_parsed` for every file as soon as it has been parsed, on the thread that parsed it
 type_safe::optional<std::vector<parsed_file>> parse(
     const cppast::libclang_compile_config&                            config,
     const type_safe::optional<cppast::libclang_compilation_database>& database,
     const std::vector<input_file>& files, const cppast::cpp_entity_index& index,
-    unsigned no_threads);
+    thread_pool& pool, parse_times& times, profiler& prof,
+    const std::function<void(const cppast::cpp_file&)>& on_parsed = {});
+
+// parses the comments of a single file, thread-safe
+void parse_comments(const standardese::file_comment_parser& parser, const cppast::cpp_file& file,
+                    profiler& prof);
 
 standardese::comment_registry parse_comments(const standardese::comment::config& config,
                                              const std::vector<parsed_file>&     files,
-                                             unsigned                            no_threads);
+                                             thread_pool& pool, profiler& prof);
 
 std::vector<std::unique_ptr<standardese::doc_cpp_file>> build_files(
     const standardese::comment_registry& registry, const cppast::cpp_entity_index& index,
     std::vector<parsed_file>&& files, const standardese::entity_blacklist& blacklist,
-    bool hide_uncommented, unsigned no_threads);
+    bool hide_uncommented, thread_pool& pool, profiler& prof);
 
 using documents = std::vector<std::unique_ptr<standardese::markup::document_entity>>;
 
 documents generate(const standardese::generation_config& gen_config,
                    const standardese::synopsis_config&   syn_config,
                    const standardese::comment_registry&  comments,
-                   const cppast::cpp_entity_index& index, const standardese::linker& linker,
+                   const cppast::cpp_entity_index& index, standardese::linker& linker,
                    const std::vector<std::unique_ptr<standardese::doc_cpp_file>>& files,
-                   unsigned                                                       no_threads);
+                   thread_pool& pool, profiler& prof,
+                   const std::function<void(const standardese::markup::document_entity&)>&
+                       on_resolved = {});
+
+void write_file(const standardese::markup::document_entity& doc,
+                standardese::markup::generator generator, const std::string& prefix,
+                const char* extension, profiler& prof);
 
+// only submits the jobs to the group, so that several formats can be written at the same time,
+// the documents must be alive until the group has been waited for
 void write_files(const documents& docs, standardese::markup::generator generator,
-                 std::string prefix, const char* extension, unsigned no_threads);
+                 std::string prefix, const char* extension, task_group& jobs, profiler& prof);
 } // namespace standardese_tool
 
 #endif // STANDARDESE_TOOL_GENERATOR_HPP_INCLUDED
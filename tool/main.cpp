@@ -11,6 +11,7 @@
 #include "filesystem.hpp"
 #include "generator.hpp"
 #include "thread_pool.hpp"
+#include "trace.hpp"
 
 namespace po = boost::program_options;
 namespace fs = boost::filesystem;
@@ -327,7 +328,19 @@ int main(int argc, char* argv[])
         ("verbose,v", po::value<bool>()->implicit_value(true)->default_value(false),
          "prints more information")
         ("jobs,j", po::value<unsigned>()->default_value(standardese_tool::default_no_threads()),
-         "sets the number of threads to use");
+         "sets the number of threads to use")
+        ("pipeline", po::value<bool>()->implicit_value(true)->default_value(false),
+         "starts the next step for a file as soon as it is ready instead of waiting for all files, "
+         "e.g. parses its comments while other files are still being parsed")
+        ("cache-dir", po::value<std::string>(),
+         "keeps information from previous runs in the given directory, "
+         "e.g. how long each file took to parse, so that the slowest files are started first")
+        ("profile", po::value<std::string>()->implicit_value(""),
+         "prints the time spent in each step and the slowest files, "
+         "and writes them as JSON to the given file if any")
+        ("trace", po::value<std::string>(),
+         "writes which thread ran which step for which file to the given file, "
+         "open it with chrome://tracing or Perfetto");
 
     configuration.add_options()
         ("input.source_ext",
@@ -434,6 +447,12 @@ int main(int argc, char* argv[])
         else
         {
             auto no_threads = get_option<unsigned>(options, "jobs").value();
+            auto pipeline   = get_option<bool>(options, "pipeline").value();
+            auto profile    = get_option<std::string>(options, "profile");
+            auto cache_dir  = get_option<std::string>(options, "cache-dir");
+            auto trace      = get_option<std::string>(options, "trace");
+            if (trace)
+                standardese_tool::enable_tracing(1u << 16);
 
             auto compile_config = get_compile_config(options);
             auto database       = get_compilation_database(options);
@@ -453,35 +472,123 @@ int main(int argc, char* argv[])
 
             try
             {
-                cppast::cpp_entity_index index;
+                // one pool for every step, so the threads are only started once
+                standardese_tool::thread_pool pool(no_threads);
+                cppast::cpp_entity_index      index;
+                standardese_tool::profiler    prof(profile.has_value());
 
-                std::clog << "parsing C++ files...\n";
-                auto parsed
-                    = standardese_tool::parse(compile_config, database, input, index, no_threads);
-                if (!parsed)
-                    return 1;
+                auto hide_uncommented = generation_config.is_flag_set(
+                    standardese::generation_config::hide_uncommented);
 
-                std::clog << "parsing documentation comments...\n";
-                auto comments
-                    = standardese_tool::parse_comments(comment_config, parsed.value(), no_threads);
-                auto files
-                    = standardese_tool::build_files(comments, index, std::move(parsed.value()),
-                                                    blacklist, generation_config.is_flag_set(standardese::generation_config::hide_uncommented), no_threads);
+                // the prefix of the output files of each format
+                std::vector<std::string> format_prefixes;
+                for (auto& format : formats)
+                {
+                    format_prefixes.push_back(
+                        formats.size() > 1u ? std::string(format.second) + '/' + prefix : prefix);
+                    if (!format_prefixes.back().empty())
+                        fs::create_directories(fs::path(format_prefixes.back()).parent_path());
+                }
 
-                std::clog << "generating documentation...\n";
-                auto docs = standardese_tool::generate(generation_config, synopsis_config, comments,
-                                                       index, linker, files, no_threads);
+                // the parse times of the previous run, so the expensive files are started first
+                standardese_tool::parse_times times;
+                type_safe::optional<fs::path> times_path;
+                if (cache_dir)
+                {
+                    times_path = fs::path(cache_dir.value()) / "parse_times";
+                    times.read(times_path.value());
+                }
 
-                for (auto& format : formats)
+                if (pipeline)
+                {
+                    // a file does not wait for the other files unless it needs information from
+                    // them
+                    std::clog << "parsing C++ files and documentation comments...\n";
+                    standardese::file_comment_parser comment_parser(cppast::default_logger(),
+                                                                    comment_config);
+                    auto parsed = standardese_tool::parse(compile_config, database, input, index,
+                                                          pool, times, prof,
+                                                          [&](const cppast::cpp_file& file) {
+                                                              standardese_tool::parse_comments(
+                                                                  comment_parser, file, prof);
+                                                          });
+                    if (times_path)
+                        times.write(times_path.value());
+                    if (!parsed)
+                        return 1;
+                    prof.record_cache("comments", comment_parser.parse_cache().hits(),
+                                      comment_parser.parse_cache().misses());
+
+                    // free comments and grouping can refer to entities in any file
+                    auto comments = comment_parser.finish();
+                    auto files
+                        = standardese_tool::build_files(comments, index, std::move(parsed.value()),
+                                                        blacklist, hide_uncommented, pool, prof);
+
+                    std::clog << "generating and writing documentation...\n";
+                    standardese_tool::generate(generation_config, synopsis_config, comments, index,
+                                               linker, files, pool, prof,
+                                               [&](const standardese::markup::document_entity& doc) {
+                                                   for (auto i = 0u; i != formats.size(); ++i)
+                                                       standardese_tool::write_file(
+                                                           doc, formats[i].first,
+                                                           format_prefixes[i], formats[i].second,
+                                                           prof);
+                                               });
+                }
+                else
+                {
+                    std::clog << "parsing C++ files...\n";
+                    auto parsed = standardese_tool::parse(compile_config, database, input, index,
+                                                          pool, times, prof);
+                    if (times_path)
+                        times.write(times_path.value());
+                    if (!parsed)
+                        return 1;
+
+                    std::clog << "parsing documentation comments...\n";
+                    auto comments
+                        = standardese_tool::parse_comments(comment_config, parsed.value(), pool,
+                                                           prof);
+                    auto files
+                        = standardese_tool::build_files(comments, index, std::move(parsed.value()),
+                                                        blacklist, hide_uncommented, pool, prof);
+
+                    std::clog << "generating documentation...\n";
+                    auto docs = standardese_tool::generate(generation_config, synopsis_config,
+                                                           comments, index, linker, files, pool,
+                                                           prof);
+
+                    // the formats are independent of each other, so they are written at the same
+                    // time
+                    standardese_tool::task_group writes(pool);
+                    for (auto i = 0u; i != formats.size(); ++i)
+                    {
+                        std::clog << "writing files in format '" << formats[i].second << "'...\n";
+                        auto stage = prof.time_stage(std::string("write ") + formats[i].second);
+                        standardese_tool::write_files(docs, formats[i].first, format_prefixes[i],
+                                                      formats[i].second, writes, prof);
+                        if (prof.enabled())
+                            // so that each format has a stage of its own
+                            writes.wait();
+                    }
+                    writes.wait();
+                }
+
+                if (prof.enabled())
+                {
+                    prof.print_report(std::clog, 10u);
+                    if (!profile.value().empty())
+                    {
+                        std::ofstream out(profile.value());
+                        prof.write_json(out);
+                    }
+                }
+
+                if (trace)
                 {
-                    std::clog << "writing files in format '" << format.second << "'...\n";
-
-                    auto format_prefix
-                        = formats.size() > 1u ? std::string(format.second) + '/' + prefix : prefix;
-                    if (!format_prefix.empty())
-                        fs::create_directories(fs::path(format_prefix).parent_path());
-                    standardese_tool::write_files(docs, format.first, std::move(format_prefix),
-                                                  format.second, no_threads);
+                    std::ofstream out(trace.value());
+                    standardese_tool::write_trace(out);
                 }
             }
             catch (std::exception& ex)
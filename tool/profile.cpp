@@ -0,0 +1,202 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "profile.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <iomanip>
+
+using namespace standardese_tool;
+
+void standardese_tool::write_json_string(std::ostream& out, const std::string& str)
+{
+    out << '"';
+    for (auto c : str)
+        if (c == '"' || c == '\\')
+            out << '\\' << c;
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            char buffer[8];
+            std::snprintf(buffer, sizeof(buffer), "\\u%04x", unsigned(c));
+            out << buffer;
+        }
+        else
+            out << c;
+    out << '"';
+}
+
+profiler::stage_timer::~stage_timer() noexcept
+{
+    if (!profiler_)
+        return;
+
+    auto wall = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - wall_);
+    auto cpu = std::chrono::microseconds(
+        static_cast<long long>((std::clock() - cpu_) * (1000000.0 / CLOCKS_PER_SEC)));
+    try
+    {
+        profiler_->record_stage(std::move(name_), wall, cpu);
+    }
+    catch (...)
+    {
+    }
+}
+
+void profiler::record_stage(std::string name, std::chrono::microseconds wall,
+                            std::chrono::microseconds cpu)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto iter = std::find_if(stages_.begin(), stages_.end(),
+                             [&](const stage& s) { return s.name == name; });
+    if (iter == stages_.end())
+        stages_.push_back({std::move(name), wall, cpu});
+    else
+    {
+        iter->wall += wall;
+        iter->cpu += cpu;
+    }
+}
+
+void profiler::record_parse(const std::string& file, std::chrono::microseconds time)
+{
+    if (!enabled_)
+        return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    files_[file].parse_time = time;
+}
+
+void profiler::record_comments(const std::string& file, std::size_t count)
+{
+    if (!enabled_)
+        return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    files_[file].comments = count;
+}
+
+void profiler::record_write(const std::string& format, std::size_t bytes,
+                            std::chrono::microseconds time)
+{
+    if (!enabled_)
+        return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto&                       stats = formats_[format];
+    ++stats.files;
+    stats.bytes += bytes;
+    stats.time += time;
+}
+
+void profiler::record_cache(const std::string& name, std::size_t hits, std::size_t misses)
+{
+    if (!enabled_)
+        return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto&                       stats = caches_[name];
+    stats.hits += hits;
+    stats.misses += misses;
+}
+
+std::vector<std::pair<std::string, profiler::file_stats>> profiler::sorted_files() const
+{
+    std::vector<std::pair<std::string, file_stats>> result(files_.begin(), files_.end());
+    std::stable_sort(result.begin(), result.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.second.parse_time > rhs.second.parse_time;
+    });
+    return result;
+}
+
+namespace
+{
+double seconds(std::chrono::microseconds time)
+{
+    return double(time.count()) / 1000000.0;
+}
+} // namespace
+
+void profiler::print_report(std::ostream& out, std::size_t top_n) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto flags     = out.flags();
+    auto precision = out.precision();
+    out << std::fixed << std::setprecision(3);
+
+    out << "profile:\n";
+    out << "  " << std::left << std::setw(24) << "stage" << std::right << std::setw(12)
+        << "wall [s]" << std::setw(12) << "cpu [s]" << '\n';
+    for (auto& s : stages_)
+        out << "  " << std::left << std::setw(24) << s.name << std::right << std::setw(12)
+            << seconds(s.wall) << std::setw(12) << seconds(s.cpu) << '\n';
+
+    for (auto& format : formats_)
+        out << "  format '" << format.first << "': " << format.second.files << " files, "
+            << format.second.bytes << " bytes written in " << seconds(format.second.time)
+            << " s\n";
+
+    for (auto& cache : caches_)
+        out << "  cache '" << cache.first << "': " << cache.second.hits << " hits, "
+            << cache.second.misses << " misses\n";
+
+    auto files = sorted_files();
+    if (!files.empty())
+    {
+        out << "  slowest files to parse:\n";
+        for (auto i = 0u; i != std::min(top_n, files.size()); ++i)
+            out << "  " << std::setw(12) << seconds(files[i].second.parse_time) << " s  "
+                << files[i].first << " (" << files[i].second.comments << " comments)\n";
+    }
+
+    out.flags(flags);
+    out.precision(precision);
+}
+
+void profiler::write_json(std::ostream& out) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    out << "{\n  \"stages\": [";
+    for (auto i = 0u; i != stages_.size(); ++i)
+    {
+        out << (i == 0u ? "\n" : ",\n") << "    {\"name\": ";
+        write_json_string(out, stages_[i].name);
+        out << ", \"wall_us\": " << stages_[i].wall.count()
+            << ", \"cpu_us\": " << stages_[i].cpu.count() << '}';
+    }
+    out << "\n  ],\n  \"formats\": [";
+    auto first = true;
+    for (auto& format : formats_)
+    {
+        out << (first ? "\n" : ",\n") << "    {\"name\": ";
+        write_json_string(out, format.first);
+        out << ", \"files\": " << format.second.files << ", \"bytes\": " << format.second.bytes
+            << ", \"time_us\": " << format.second.time.count() << '}';
+        first = false;
+    }
+    out << "\n  ],\n  \"caches\": [";
+    first = true;
+    for (auto& cache : caches_)
+    {
+        out << (first ? "\n" : ",\n") << "    {\"name\": ";
+        write_json_string(out, cache.first);
+        out << ", \"hits\": " << cache.second.hits << ", \"misses\": " << cache.second.misses
+            << '}';
+        first = false;
+    }
+    out << "\n  ],\n  \"files\": [";
+    auto files = sorted_files();
+    for (auto i = 0u; i != files.size(); ++i)
+    {
+        out << (i == 0u ? "\n" : ",\n") << "    {\"path\": ";
+        write_json_string(out, files[i].first);
+        out << ", \"parse_us\": " << files[i].second.parse_time.count()
+            << ", \"comments\": " << files[i].second.comments << '}';
+    }
+    out << "\n  ]\n}\n";
+}
@@ -0,0 +1,131 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef STANDARDESE_TOOL_PROFILE_HPP_INCLUDED
+#define STANDARDESE_TOOL_PROFILE_HPP_INCLUDED
+
+#include <chrono>
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace standardese_tool
+{
+// writes `str` as a JSON string literal, including the quotes
+void write_json_string(std::ostream& out, const std::string& str);
+
+// records where the time of a run goes, does nothing unless enabled
+class profiler
+{
+public:
+    explicit profiler(bool enabled) : enabled_(enabled) {}
+
+    profiler(const profiler&) = delete;
+    profiler& operator=(const profiler&) = delete;
+
+    bool enabled() const noexcept
+    {
+        return enabled_;
+    }
+
+    // records the wall and CPU time between its construction and destruction as a stage,
+    // the CPU time is the one of the whole process, i.e. summed over all threads
+    class stage_timer
+    {
+    public:
+        stage_timer(stage_timer&& other) noexcept
+        : profiler_(other.profiler_), name_(std::move(other.name_)), wall_(other.wall_),
+          cpu_(other.cpu_)
+        {
+            other.profiler_ = nullptr;
+        }
+
+        ~stage_timer() noexcept;
+
+        stage_timer& operator=(const stage_timer&) = delete;
+
+    private:
+        stage_timer(profiler* p, std::string name)
+        : profiler_(p), name_(std::move(name)), wall_(std::chrono::steady_clock::now()),
+          cpu_(std::clock())
+        {}
+
+        profiler*                             profiler_;
+        std::string                           name_;
+        std::chrono::steady_clock::time_point wall_;
+        std::clock_t                          cpu_;
+
+        friend profiler;
+    };
+
+    // a stage that is entered several times accumulates its times
+    stage_timer time_stage(std::string name)
+    {
+        return stage_timer(enabled_ ? this : nullptr, std::move(name));
+    }
+
+    // the remaining functions are thread-safe
+
+    void record_parse(const std::string& file, std::chrono::microseconds time);
+
+    void record_comments(const std::string& file, std::size_t count);
+
+    // records an output file of the given format, `time` is how long the file took to write
+    void record_write(const std::string& format, std::size_t bytes,
+                      std::chrono::microseconds time);
+
+    // adds to the hits and misses of the cache with the given name
+    void record_cache(const std::string& name, std::size_t hits, std::size_t misses);
+
+    // prints the times of the stages and the `top_n` files that took the longest to parse
+    void print_report(std::ostream& out, std::size_t top_n) const;
+
+    void write_json(std::ostream& out) const;
+
+private:
+    struct stage
+    {
+        std::string               name;
+        std::chrono::microseconds wall;
+        std::chrono::microseconds cpu;
+    };
+
+    struct file_stats
+    {
+        std::chrono::microseconds parse_time{0};
+        std::size_t               comments = 0u;
+    };
+
+    struct cache_stats
+    {
+        std::size_t hits   = 0u;
+        std::size_t misses = 0u;
+    };
+
+    struct format_stats
+    {
+        std::size_t               files = 0u;
+        std::size_t               bytes = 0u;
+        std::chrono::microseconds time{0};
+    };
+
+    void record_stage(std::string name, std::chrono::microseconds wall,
+                      std::chrono::microseconds cpu);
+
+    // the files sorted by their parse time, slowest first
+    std::vector<std::pair<std::string, file_stats>> sorted_files() const;
+
+    mutable std::mutex                  mutex_;
+    std::vector<stage>                  stages_; // in the order they were first entered
+    std::map<std::string, file_stats>   files_;
+    std::map<std::string, format_stats> formats_;
+    std::map<std::string, cache_stats>  caches_;
+    bool                                enabled_;
+};
+} // namespace standardese_tool
+
+#endif // STANDARDESE_TOOL_PROFILE_HPP_INCLUDED
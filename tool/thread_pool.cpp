@@ -0,0 +1,145 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "thread_pool.hpp"
+
+#include <utility>
+
+using namespace standardese_tool;
+
+namespace
+{
+// the pool the current thread is a worker of, if any, and its index there
+thread_local const void* current_pool  = nullptr;
+thread_local unsigned    current_index = 0u;
+} // namespace
+
+thread_pool::thread_pool(unsigned no_threads)
+{
+    no_threads = std::max(no_threads, 1u);
+
+    for (auto i = 0u; i <= no_threads; ++i)
+        queues_.push_back(std::unique_ptr<job_queue>(new job_queue));
+
+    workers_.reserve(no_threads);
+    for (auto i = 0u; i != no_threads; ++i)
+        workers_.emplace_back([this, i] { work(i); });
+}
+
+thread_pool::~thread_pool() noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stop_ = true;
+    }
+    wake_up_.notify_all();
+
+    for (auto& worker : workers_)
+        worker.join();
+}
+
+void thread_pool::submit(job j)
+{
+    auto index = current_pool == this ? current_index : unsigned(workers_.size());
+    ++no_pending_;
+    {
+        std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+        queues_[index]->jobs.push_back(std::move(j));
+    }
+
+    // lock the mutex, so a worker cannot miss the notification
+    // between checking for pending jobs and going to sleep
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+    }
+    wake_up_.notify_one();
+}
+
+bool thread_pool::try_run_one()
+{
+    auto own = current_pool == this ? current_index : unsigned(workers_.size());
+
+    job j;
+    for (auto i = 0u; i != queues_.size() && !j; ++i)
+    {
+        auto  index = (own + i) % queues_.size();
+        auto& queue = *queues_[index];
+
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.jobs.empty())
+            continue;
+        else if (index == own && current_pool == this)
+        {
+            // our own jobs are taken newest first, they are the most likely to be in cache
+            j = std::move(queue.jobs.back());
+            queue.jobs.pop_back();
+        }
+        else
+        {
+            // other jobs are taken oldest first, they are likely to spawn more work,
+            // and the jobs from outside the pool are run in the order they were submitted
+            j = std::move(queue.jobs.front());
+            queue.jobs.pop_front();
+        }
+    }
+    if (!j)
+        return false;
+
+    --no_pending_;
+    j();
+    return true;
+}
+
+void thread_pool::work(unsigned index)
+{
+    current_pool  = this;
+    current_index = index;
+
+    while (true)
+    {
+        if (try_run_one())
+            continue;
+
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        wake_up_.wait(lock, [&] { return stop_ || no_pending_ > 0u; });
+        if (stop_ && no_pending_ == 0u)
+            break;
+    }
+}
+
+task_group::~task_group() noexcept
+{
+    try
+    {
+        wait();
+    }
+    catch (...)
+    {
+    }
+}
+
+void task_group::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (no_running_ != 0u)
+    {
+        auto finished = no_finished_;
+        lock.unlock();
+
+        // help out instead of blocking a thread that might be needed to finish our jobs
+        auto ran = pool_.try_run_one();
+
+        lock.lock();
+        if (!ran)
+        {
+            // nothing to help with until one of our jobs finishes
+            ++no_waiters_;
+            done_.wait(lock, [&] { return no_running_ == 0u || no_finished_ != finished; });
+            --no_waiters_;
+        }
+    }
+
+    if (auto exception = std::exchange(exception_, nullptr))
+        std::rethrow_exception(exception);
+}
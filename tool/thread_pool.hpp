@@ -5,27 +5,138 @@
 #ifndef STANDARDESE_THREAD_POOL_HPP_INCLUDED
 #define STANDARDESE_THREAD_POOL_HPP_INCLUDED
 
-#include <future>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <thread>
 #include <vector>
 
-#include <ThreadPool.h>
-
 namespace standardese_tool
 {
-using thread_pool = ::ThreadPool;
-
 inline unsigned default_no_threads()
 {
     return std::max(std::thread::hardware_concurrency(), 1u);
 }
 
-template <typename Fnc, typename... Args>
-auto add_job(thread_pool& p, Fnc f, Args&&... args)
-    -> std::future<typename std::result_of<Fnc(Args...)>::type>
+/// A pool of worker threads that is used for the whole run of the tool.
+///
+/// Every worker has its own queue of jobs.
+/// It takes the jobs it submits itself from the back of its queue,
+/// and when it runs out of jobs it steals from the front of the other queues.
+/// Jobs are submitted using a [standardese_tool::task_group]().
+class thread_pool
 {
-    return p.enqueue(f, std::forward<Args>(args)...);
-}
+public:
+    /// \effects Starts the given number of worker threads.
+    explicit thread_pool(unsigned no_threads);
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    /// \effects Finishes all remaining jobs and stops the worker threads.
+    ~thread_pool() noexcept;
+
+    /// \returns The number of worker threads.
+    unsigned size() const noexcept
+    {
+        return unsigned(workers_.size());
+    }
+
+private:
+    using job = std::function<void()>;
+
+    struct job_queue
+    {
+        std::mutex      mutex;
+        std::deque<job> jobs;
+    };
+
+    void submit(job j);
+
+    // runs a single pending job, returns false if there was none
+    bool try_run_one();
+
+    void work(unsigned index);
+
+    // one queue per worker, followed by one for threads outside of the pool
+    std::vector<std::unique_ptr<job_queue>> queues_;
+    std::vector<std::thread>                workers_;
+
+    std::atomic<std::size_t> no_pending_{0};
+    std::mutex               sleep_mutex_;
+    std::condition_variable  wake_up_;
+    bool                     stop_ = false;
+
+    friend class task_group;
+};
+
+/// A group of jobs that are run on a [standardese_tool::thread_pool]() and waited for together.
+///
+/// Jobs can create and wait for groups of their own.
+class task_group
+{
+public:
+    /// \effects Creates an empty group.
+    explicit task_group(thread_pool& pool) : pool_(pool) {}
+
+    task_group(const task_group&) = delete;
+    task_group& operator=(const task_group&) = delete;
+
+    /// \effects Waits for all jobs of the group, ignoring their exceptions.
+    ~task_group() noexcept;
+
+    /// \effects Submits a job to the pool.
+    /// \notes This function is thread safe.
+    template <typename Fnc>
+    void run(Fnc f)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++no_running_;
+        }
+
+        pool_.submit([this, f = std::move(f)]() mutable {
+            std::exception_ptr exception;
+            try
+            {
+                f();
+            }
+            catch (...)
+            {
+                exception = std::current_exception();
+            }
+
+            // the group might be destroyed as soon as the last job is done,
+            // so this must be the last access
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (exception && !exception_)
+                exception_ = exception;
+            ++no_finished_;
+            // a waiter also wakes up for every finished job, as it might have submitted new ones
+            if (--no_running_ == 0u || no_waiters_ != 0u)
+                done_.notify_all();
+        });
+    }
+
+    /// \effects Waits until all jobs submitted so far have finished.
+    /// While waiting, the calling thread runs pending jobs of the pool.
+    /// \throws The first exception that was thrown by one of the jobs.
+    void wait();
+
+private:
+    thread_pool&            pool_;
+    std::mutex              mutex_;
+    std::condition_variable done_;
+    std::size_t             no_running_  = 0u;
+    std::size_t             no_finished_ = 0u;
+    std::size_t             no_waiters_  = 0u;
+    std::exception_ptr      exception_;
+};
 } // namespace standardese_tool
 
 #endif // STANDARDESE_THREAD_POOL_HPP_INCLUDED
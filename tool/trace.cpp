@@ -0,0 +1,132 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "trace.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "profile.hpp"
+
+using namespace standardese_tool;
+
+std::atomic<bool> standardese_tool::detail::tracing(false);
+
+namespace
+{
+struct event
+{
+    const char*                           name;
+    std::string                           detail;
+    std::chrono::steady_clock::time_point begin, end;
+};
+
+// only written by its thread, old events are overwritten once it is full
+struct event_buffer
+{
+    std::vector<event> events;
+    std::size_t        next = 0u;  // where the next event is written
+    std::size_t        count = 0u; // number of events recorded in total
+    unsigned           thread;
+};
+
+std::mutex                                 buffers_mutex;
+std::vector<std::unique_ptr<event_buffer>> buffers; // live until the end of the program
+std::size_t                                buffer_size = 0u;
+std::chrono::steady_clock::time_point      start;
+
+event_buffer& get_buffer()
+{
+    thread_local event_buffer* buffer = nullptr;
+    if (!buffer)
+    {
+        std::lock_guard<std::mutex> lock(buffers_mutex);
+        buffers.push_back(std::unique_ptr<event_buffer>(new event_buffer));
+        buffer         = buffers.back().get();
+        buffer->thread = unsigned(buffers.size());
+        buffer->events.resize(buffer_size);
+    }
+    return *buffer;
+}
+
+long long microseconds_since_start(std::chrono::steady_clock::time_point time)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(time - start).count();
+}
+} // namespace
+
+void standardese_tool::enable_tracing(std::size_t events_per_thread)
+{
+    {
+        std::lock_guard<std::mutex> lock(buffers_mutex);
+        buffer_size = std::max(events_per_thread, std::size_t(1u));
+        start       = std::chrono::steady_clock::now();
+    }
+    detail::tracing = true;
+}
+
+void trace_scope::record() noexcept
+{
+    auto end = std::chrono::steady_clock::now();
+    try
+    {
+        auto& buffer = get_buffer();
+        auto& e      = buffer.events[buffer.next];
+        e.name       = name_;
+        e.detail.assign(detail_ ? detail_ : "");
+        e.begin = begin_;
+        e.end   = end;
+
+        buffer.next = (buffer.next + 1u) % buffer.events.size();
+        ++buffer.count;
+    }
+    catch (...)
+    {
+    }
+}
+
+void standardese_tool::write_trace(std::ostream& out)
+{
+    std::lock_guard<std::mutex> lock(buffers_mutex);
+
+    auto first = true;
+    auto begin_event = [&] {
+        out << (first ? "\n" : ",\n") << "  {";
+        first = false;
+    };
+
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    for (auto& buffer : buffers)
+    {
+        begin_event();
+        out << "\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->thread
+            << ", \"args\": {\"name\": \"thread " << buffer->thread << "\"}}";
+
+        // the oldest event is the next one to be overwritten, unless the buffer is not full yet
+        auto size   = std::min(buffer->count, buffer->events.size());
+        auto oldest = buffer->count > size ? buffer->next : 0u;
+        for (auto i = 0u; i != size; ++i)
+        {
+            auto& e = buffer->events[(oldest + i) % buffer->events.size()];
+
+            begin_event();
+            out << "\"name\": \"" << e.name << "\", \"cat\": \"standardese\", \"ph\": \"X\", "
+                << "\"ts\": " << microseconds_since_start(e.begin)
+                << ", \"dur\": "
+                << std::chrono::duration_cast<std::chrono::microseconds>(e.end - e.begin).count()
+                << ", \"pid\": 1, \"tid\": " << buffer->thread;
+            if (!e.detail.empty())
+            {
+                out << ", \"args\": {\"detail\": ";
+                write_json_string(out, e.detail);
+                out << '}';
+            }
+            out << '}';
+        }
+    }
+    out << "\n]}\n";
+}
@@ -0,0 +1,65 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef STANDARDESE_TOOL_TRACE_HPP_INCLUDED
+#define STANDARDESE_TOOL_TRACE_HPP_INCLUDED
+
+#include <atomic>
+#include <chrono>
+#include <ostream>
+
+namespace standardese_tool
+{
+namespace detail
+{
+    extern std::atomic<bool> tracing;
+} // namespace detail
+
+// records which thread ran which job and when,
+// in the trace event format understood by chrome://tracing and Perfetto,
+// each thread keeps the last `events_per_thread` events
+void enable_tracing(std::size_t events_per_thread);
+
+inline bool is_tracing() noexcept
+{
+    return detail::tracing.load(std::memory_order_relaxed);
+}
+
+// writes all recorded events,
+// must not be called while jobs are running
+void write_trace(std::ostream& out);
+
+// records an event from its construction to its destruction,
+// does nothing but a single check unless tracing is enabled
+class trace_scope
+{
+public:
+    // `name` must be a string literal,
+    // `detail` is copied at the end of the event
+    explicit trace_scope(const char* name, const char* detail = nullptr) noexcept
+    : name_(is_tracing() ? name : nullptr), detail_(detail)
+    {
+        if (name_)
+            begin_ = std::chrono::steady_clock::now();
+    }
+
+    trace_scope(const trace_scope&) = delete;
+    trace_scope& operator=(const trace_scope&) = delete;
+
+    ~trace_scope() noexcept
+    {
+        if (name_)
+            record();
+    }
+
+private:
+    void record() noexcept;
+
+    const char*                           name_;
+    const char*                           detail_;
+    std::chrono::steady_clock::time_point begin_;
+};
+} // namespace standardese_tool
+
+#endif // STANDARDESE_TOOL_TRACE_HPP_INCLUDED